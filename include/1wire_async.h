@@ -0,0 +1,74 @@
+/*!
+ * \file
+ * \brief 1 wire asynchronous transaction interface header file
+ * \author Dawid Babula
+ * \email dbabula@adventurous.pl
+ *
+ * \par Copyright (C) Dawid Babula, 2020
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef IWIRE_ASYNC_H
+#define IWIRE_ASYNC_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/*!
+ *
+ * \addtogroup 1wire_async
+ * \ingroup 1wire_mgr
+ * \brief Interface of engine clocking 1Wire transactions in background
+ */
+
+/*@{*/
+
+/*!
+ * \brief Maximal number of bytes sent in single transaction
+ *
+ * \details MATCH_ROM with rom space, function command and three bytes of
+ * WRITE_SCRATCHPAD
+ */
+#define WIRE_TRANSACTION_TX_SIZE        (13u)
+
+/*!
+ * \brief 1Wire transaction, reset followed by written and read bytes
+ */
+typedef struct
+{
+    uint8_t tx[WIRE_TRANSACTION_TX_SIZE]; /*!< bytes sent after reset */
+    uint8_t tx_len; /*!< number of bytes to be sent */
+    uint8_t *rx; /*!< storage for read bytes */
+    uint8_t rx_len; /*!< number of bytes to be read */
+    bool is_pullup; /*!< strong pullup is enabled after last sent byte */
+    bool is_abort; /*!< transfer is aborted with reset after last read byte */
+    volatile bool is_presence; /*!< presence pulse has been detected */
+    volatile bool is_done; /*!< transaction is finished */
+} WIRE_transaction_t;
+
+/*!
+ * \brief Starts transaction in background
+ *
+ * \details Engine issues reset and if presence pulse is detected sends tx
+ * bytes and reads rx bytes. Finished transaction is signalled with is_done
+ * flag, transaction storage must be kept valid till then.
+ *
+ * \param transaction transaction to be started
+ */
+void WIRE_async_start(WIRE_transaction_t *transaction);
+
+/*@}*/
+#endif
@@ -49,18 +49,192 @@
 #define WIRE_12BIT_RESOLUTION           (3u)
 /*@}*/
 
+/*!
+ *
+ * \addtogroup WIRE_MGR_crc_engines
+ * \ingroup 1wire_mgr
+ * \brief Crc engines selectable at build time with WIRE_MGR_CRC_ENGINE
+ */
+/*@{*/
+#define WIRE_MGR_CRC_TABLE              (0u) /*!< 256 bytes flash table, fastest */
+#define WIRE_MGR_CRC_NIBBLE             (1u) /*!< two 16 bytes flash tables */
+#define WIRE_MGR_CRC_BITWISE            (2u) /*!< no table, slowest */
+/*@}*/
+
+/*!
+ *
+ * \addtogroup WIRE_MGR_status
+ * \ingroup 1wire_mgr
+ * \brief Status of 1Wire manager operation
+ */
+/*@{*/
+#define WIRE_MGR_SUCCESS                (0u) /*!< temperature read */
+#define WIRE_MGR_CRC_ERROR              (1u) /*!< crc mismatch */
+#define WIRE_MGR_NO_PRESENCE_ERROR      (2u) /*!< no sensor answered reset */
+#define WIRE_MGR_FAKE_SENSOR_ERROR      (3u) /*!< not genuine sensor */
+#define WIRE_MGR_CONFIG_ERROR           (4u) /*!< written configuration not read back */
+/*@}*/
+
+/*!
+ *
+ * \addtogroup WIRE_MGR_filters
+ * \ingroup 1wire_mgr
+ * \brief Filters of temperature readings
+ */
+/*@{*/
+#define WIRE_MGR_FILTER_NONE            (0u) /*!< last accepted reading */
+#define WIRE_MGR_FILTER_EMA             (1u) /*!< exponential moving average */
+#define WIRE_MGR_FILTER_MEDIAN          (2u) /*!< median of last readings */
+/*@}*/
+
+#ifndef WIRE_MGR_EMA_SHIFT
+/*!
+ * \brief Weight of new reading in exponential moving average as power of
+ * two, value n gives weight 1/2^n
+ */
+#define WIRE_MGR_EMA_SHIFT              (2u)
+#endif
+
+#ifndef WIRE_MGR_MEDIAN_SIZE
+/*!
+ * \brief Number of readings in median filter window
+ */
+#define WIRE_MGR_MEDIAN_SIZE            (3u)
+#endif
+
+#ifndef WIRE_MGR_SAMPLES_SIZE
+/*!
+ * \brief Number of samples kept in history
+ *
+ * \note Has to be power of two, so history stays continuous when sequence
+ * number wraps
+ */
+#define WIRE_MGR_SAMPLES_SIZE           (8u)
+#endif
+
+#ifndef WIRE_MGR_MAX_DEVICES
+/*!
+ * \brief Maximal number of sensors handled on single bus
+ *
+ * \details Each sensor takes 23 bytes of device table entry with default
+ * \ref WIRE_MGR_MEDIAN_SIZE, 8 bytes of background search list and 4 bytes
+ * of snapshot, 35 bytes in total. Statistics add 42 bytes, unless disabled
+ * with WIRE_MGR_STATS_ENABLED, and each extra median window reading adds
+ * 2 bytes. 32 sensors take about 1.1 KB without statistics.
+ */
+#define WIRE_MGR_MAX_DEVICES            (8u)
+#endif
+
+#ifndef WIRE_MGR_MAX_BUSES
+/*!
+ * \brief Maximal number of buses, including the default one
+ */
+#define WIRE_MGR_MAX_BUSES              (1u)
+#endif
+
+/*!
+ * \brief Number of sensors in snapshot, sensors of all buses
+ */
+#define WIRE_MGR_SNAPSHOT_SIZE          (WIRE_MGR_MAX_DEVICES * WIRE_MGR_MAX_BUSES)
+
+/*!
+ * \brief Primitives of 1Wire bus
+ *
+ * \details Default bus is bound to functions of 1Wire driver, additional
+ * buses e.g. on other pins provide their own
+ */
+typedef struct
+{
+    bool (*reset)(void); /*!< issues reset, returns true on presence pulse */
+    void (*send_byte)(uint8_t byte); /*!< sends byte */
+    uint8_t (*read_byte)(void); /*!< reads byte */
+    void (*send_bit)(bool bit); /*!< sends bit */
+    bool (*read_bit)(void); /*!< reads bit */
+    void (*set_strong_pullup)(bool is_enabled); /*!< switches strong pullup */
+} WIRE_MGR_port_t;
+
 /*!
  * \brief 1Wire manager configuration structure
+ *
+ * \details Transaction or search yielded on used up bus_budget resumes on
+ * the next task call, which is 10 ms later in fast scheduling, but
+ * whole task period, 1 s, later in classic scheduling
  */
 typedef struct
 {
     bool is_crc; /*!< sets crc checking */
     bool is_fake_allowed; /*!< allows fake DS18B20 chips */
     uint8_t resolution; /*!< sets resolution of DS18B20 temperature readings */
+    bool is_sweep; /*!< converts all sensors at once with broadcast CONVERT_T */
+    bool is_fast_scheduling; /*!< schedules task by deadlines of states instead of fixed period */
+    uint8_t poll_interval; /*!< interval of polling for early conversion completion, 0 disables polling */
+    bool is_fast_read; /*!< reads only temperature bytes of scratchpad, if crc checking is off */
+    bool is_adaptive_resolution; /*!< drops resolution of fast changing sensors, resolution is the maximal one */
+    bool is_alarm_sweep; /*!< converts all sensors at once and reads only the alarming ones */
+    uint8_t filter; /*!< filter of readings, one of \ref WIRE_MGR_filters */
+    bool is_hot_plug; /*!< searches bus for added and removed sensors in background */
+    bool is_persistent; /*!< copies written configuration to EEPROM of sensors */
+    uint16_t sample_interval; /*!< ticks between starts of sampling rounds, 0 samples continuously */
+    uint8_t bus_budget; /*!< resets and bytes clocked in blocking way per task call, 0 is unlimited */
+    uint8_t read_retries; /*!< immediate re-reads of conversion result after crc or presence error */
 } WIRE_MGR_config_t;
 
 /*!
- * \brief Gets last read temperature
+ * \brief Sample kept in history of 1Wire manager
+ */
+typedef struct
+{
+    uint32_t tick; /*!< system tick of logging the sample */
+    uint16_t seq; /*!< sequence number of the sample */
+    uint8_t idx; /*!< index of sensor in device table */
+    uint8_t status; /*!< status of operation, one of \ref WIRE_MGR_status */
+    int16_t raw; /*!< raw temperature, valid for \ref WIRE_MGR_SUCCESS */
+} WIRE_MGR_sample_t;
+
+/*!
+ * \brief Snapshot of temperatures of all sensors, published at once
+ */
+typedef struct
+{
+    uint32_t tick; /*!< system tick of publishing */
+    uint8_t count; /*!< number of sensors in device table */
+    uint8_t ready_mask[(WIRE_MGR_SNAPSHOT_SIZE + 7u) / 8u]; /*!< bit per sensor, set if temperature is valid */
+    int16_t temperature[WIRE_MGR_SNAPSHOT_SIZE]; /*!< raw temperatures */
+} WIRE_MGR_snapshot_t;
+
+/*!
+ * \brief Statistics of sensor
+ *
+ * \details Bus time is time spent in manager handlers since previous result
+ * of the sensor, latency is time from start of conversion till successful
+ * read. Times are in system ticks.
+ */
+typedef struct
+{
+    uint32_t success; /*!< number of successful reads */
+    uint32_t crc_errors; /*!< number of crc errors */
+    uint32_t no_presence_errors; /*!< number of missing presence pulses */
+    uint32_t fake_errors; /*!< number of fake sensor detections */
+    uint32_t config_errors; /*!< number of failed configuration writes */
+    uint32_t retries; /*!< number of immediate re-reads of conversion result */
+    uint16_t bus_time_min; /*!< minimal bus time of result */
+    uint16_t bus_time_avg; /*!< average bus time of result */
+    uint16_t bus_time_max; /*!< maximal bus time of result */
+    uint16_t latency_min; /*!< minimal latency of sample */
+    uint16_t latency_avg; /*!< average latency of sample */
+    uint16_t latency_max; /*!< maximal latency of sample */
+} WIRE_MGR_stats_t;
+
+/*!
+ * \brief Callback called when new temperature has been read
+ *
+ * \param idx index of sensor in device table
+ * \param raw raw temperature
+ */
+typedef void (*WIRE_MGR_sample_cb_t)(uint8_t idx, int16_t raw);
+
+/*!
+ * \brief Gets last read temperature of first sensor found on the bus
  *
  * \param out storage for read temperature
  *
@@ -69,6 +243,178 @@ typedef struct
  */
 bool WIRE_MGR_get_temperature(int16_t *out);
 
+/*!
+ * \brief Gets last read temperature of given sensor
+ *
+ * \param idx index of sensor in device table
+ * \param out storage for read temperature
+ *
+ * \retval true valid temperature value read
+ * \retval false sensor is not ready yet or index is out of range
+ */
+bool WIRE_MGR_get_temperature_n(uint8_t idx, int16_t *out);
+
+/*!
+ * \brief Gets filtered temperature of given sensor
+ *
+ * \details Readings are filtered with filter selected by configuration.
+ * Power on reset value of sensor, which is not preceded by similar
+ * readings, is rejected by filter as a spike.
+ *
+ * \param idx index of sensor in device table
+ * \param out storage for filtered temperature
+ *
+ * \retval true valid temperature value read
+ * \retval false no reading accepted yet or index is out of range
+ */
+bool WIRE_MGR_get_filtered_temperature(uint8_t idx, int16_t *out);
+
+/*!
+ * \brief Gets number of sensors found on all buses
+ *
+ * \details Sensors are indexed across buses in order of bus registration,
+ * sensors of the default bus come first
+ *
+ * \returns number of sensors in device table
+ */
+uint8_t WIRE_MGR_get_devices_count(void);
+
+/*!
+ * \brief Gets number of sensors found on given bus
+ *
+ * \param bus_idx index of bus, 0 is the default bus
+ *
+ * \returns number of sensors of the bus, 0 if index is out of range
+ */
+uint8_t WIRE_MGR_get_bus_devices_count(uint8_t bus_idx);
+
+/*!
+ * \brief Copies samples logged since given sequence number
+ *
+ * \details If consumer fell behind by more than \ref WIRE_MGR_SAMPLES_SIZE
+ * samples, copying starts from the oldest sample kept, which can be noticed
+ * by sequence number of the first copied sample.
+ *
+ * \param seq sequence number of first sample to be copied, on return
+ * sequence number of next sample to be copied
+ * \param out storage for copied samples
+ * \param size number of samples fitting into storage
+ *
+ * \returns number of copied samples
+ */
+uint8_t WIRE_MGR_read_samples(uint16_t *seq, WIRE_MGR_sample_t *out, uint8_t size);
+
+/*!
+ * \brief Copies last published snapshot
+ *
+ * \details Snapshot is republished after each readout. It is double
+ * buffered with sequence counter, so it can be copied from any context
+ * without disabling interrupts. Copy made in interrupt always succeeds,
+ * as publishing can't progress meanwhile.
+ *
+ * \param out storage for snapshot
+ *
+ * \retval true consistent snapshot copied
+ * \retval false snapshot has been republished while copying, copy should
+ * be repeated
+ */
+bool WIRE_MGR_read_snapshot(WIRE_MGR_snapshot_t *out);
+
+/*!
+ * \brief Gets statistics of given sensor
+ *
+ * \param idx index of sensor in device table
+ * \param out storage for statistics
+ *
+ * \retval true statistics copied
+ * \retval false index is out of range or statistics are disabled with
+ * WIRE_MGR_STATS_ENABLED
+ */
+bool WIRE_MGR_get_stats(uint8_t idx, WIRE_MGR_stats_t *out);
+
+/*!
+ * \brief Sets alarm thresholds of given sensor
+ *
+ * \details Thresholds are written to the sensor by the manager task. In
+ * alarm sweep mode only sensors, which temperature is out of the bounds,
+ * are read.
+ *
+ * \param idx index of sensor in device table
+ * \param th high alarm threshold in Celsius degrees
+ * \param tl low alarm threshold in Celsius degrees
+ *
+ * \retval true thresholds set
+ * \retval false index is out of range or th is lower than tl
+ */
+bool WIRE_MGR_set_alarm(uint8_t idx, int8_t th, int8_t tl);
+
+/*!
+ * \brief Registers callback called when new temperature has been read
+ *
+ * \note Callback is called from 1Wire manager task, so it should be short
+ *
+ * \param cb callback to be registered, NULL unregisters callback
+ */
+void WIRE_MGR_register_sample_callback(WIRE_MGR_sample_cb_t cb);
+
+/*!
+ * \brief Sets configuration of 1Wire manager at runtime
+ *
+ * \details Configuration is validated and copied into RAM, values derived
+ * from it are computed once. Sensors are reconfigured by the manager task
+ * if resolution changes. wire_mgr_config stored in flash is used as
+ * configuration till this is called.
+ *
+ * \note is_fast_scheduling is applied only by \ref WIRE_MGR_initialize,
+ * so it can't be changed
+ *
+ * \param cfg configuration to be set
+ *
+ * \retval true configuration set
+ * \retval false configuration is invalid or changes is_fast_scheduling,
+ * previous one is kept
+ */
+bool WIRE_MGR_set_config(const WIRE_MGR_config_t *cfg);
+
+/*!
+ * \brief Gets configuration of 1Wire manager
+ *
+ * \param out storage for configuration
+ */
+void WIRE_MGR_get_config(WIRE_MGR_config_t *out);
+
+/*!
+ * \brief Checks whatever manager has nothing to do for a while
+ *
+ * \details Lets system sleep till the next deadline of the manager, e.g.
+ * end of conversion or start of next sampling round. Deadlines are known
+ * only in fast scheduling mode. For long sleeps polling for conversion
+ * completion should be disabled, as it wakes up every poll interval.
+ *
+ * \param wakeup_in storage for ticks till the next deadline
+ *
+ * \retval true manager is idle, wakeup_in is valid
+ * \retval false manager has work to do or is not in fast scheduling mode
+ */
+bool WIRE_MGR_is_idle(uint16_t *wakeup_in);
+
+/*!
+ * \brief Registers additional bus
+ *
+ * \details Bus gets next free index, it is handled by the manager task
+ * together with other buses. Has to be called after \ref
+ * WIRE_MGR_initialize, port has to be kept valid.
+ *
+ * \note Asynchronous engine drives only the default bus, transactions of
+ * additional buses are clocked in blocking way
+ *
+ * \param port primitives of the bus
+ *
+ * \retval true bus registered
+ * \retval false \ref WIRE_MGR_MAX_BUSES buses registered already
+ */
+bool WIRE_MGR_register_bus(const WIRE_MGR_port_t *port);
+
 /*!
  * \brief Initializes 1Wire manager
  */
@@ -0,0 +1,52 @@
+/*!
+ * \file
+ * \brief 1 wire UART backend header file
+ * \author Dawid Babula
+ * \email dbabula@adventurous.pl
+ *
+ * \par Copyright (C) Dawid Babula, 2020
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef IWIRE_UART_H
+#define IWIRE_UART_H
+
+/*!
+ *
+ * \addtogroup 1wire_uart
+ * \ingroup 1wire_mgr
+ * \brief 1Wire bus driven by USART
+ *
+ * \details Every bit slot is a single USART frame, 0xF0 at 9600 baud for
+ * reset/presence and 0x00/0xFF at 115200 baud for write/read slots. TX and
+ * RX pins are tied together through open drain driver, so echo of each
+ * frame tells state of the bus. Timing is done by hardware, so interrupts
+ * stay enabled during transfers.
+ *
+ * Backend is selected at build time with WIRE_MGR_BACKEND := uart and
+ * replaces bit banged 1Wire driver, it also provides \ref WIRE_async_start
+ * engine driven from USART receive interrupt.
+ */
+
+/*@{*/
+
+/*!
+ * \brief Initializes USART for 1Wire bus
+ */
+void WIRE_UART_initialize(void);
+
+/*@}*/
+#endif
@@ -25,20 +25,185 @@
 #define DEBUG_LEVEL     DEBUG_1WIRE_MGR_LEVEL
 
 #include "1wire_mgr.h"
+#include "1wire_async.h"
 #include "1wire.h"
 #include "system.h"
 #include "debug.h"
 #include "system_timer.h"
 #include <stddef.h>
+#include <string.h>
 #include <limits.h>
 #include <avr/pgmspace.h>
+#include <avr/eeprom.h>
 #include "hardware.h"
 
-#define LOG_SUCCESS                 (0U)
-#define LOG_CRC_ERROR               (1U)
-#define LOG_NO_PRESENCE_ERROR       (2U)
-#define LOG_FAKE_SENSOR_ERROR       (3u)
-#define LOG_SENTINEL                (4U)
+#ifndef WIRE_MGR_ASYNC_ENABLED
+/*!
+ * \brief Enables clocking of transactions in background by
+ * \ref WIRE_async_start engine
+ *
+ * \note Engine is provided by USART backend, which defines
+ * WIRE_MGR_ASYNC_ENGINE, bit banged driver does not have any
+ */
+#define WIRE_MGR_ASYNC_ENABLED      (0)
+#endif
+
+#if WIRE_MGR_ASYNC_ENABLED && !defined(WIRE_MGR_ASYNC_ENGINE)
+#error "WIRE_MGR_ASYNC_ENABLED needs engine providing WIRE_async_start, e.g. WIRE_MGR_BACKEND=uart"
+#endif
+
+#ifndef WIRE_MGR_CRC_ENGINE
+/*!
+ * \brief Selects crc engine, one of \ref WIRE_MGR_crc_engines
+ */
+#define WIRE_MGR_CRC_ENGINE         WIRE_MGR_CRC_TABLE
+#endif
+
+#ifndef WIRE_MGR_FAMILY_DS18B20
+/*!
+ * \brief Enables support of DS18B20 sensors
+ */
+#define WIRE_MGR_FAMILY_DS18B20     (1)
+#endif
+
+#ifndef WIRE_MGR_FAMILY_DS18S20
+/*!
+ * \brief Enables support of DS18S20 sensors
+ */
+#define WIRE_MGR_FAMILY_DS18S20     (0)
+#endif
+
+#ifndef WIRE_MGR_FAMILY_DS1822
+/*!
+ * \brief Enables support of DS1822 sensors
+ */
+#define WIRE_MGR_FAMILY_DS1822      (0)
+#endif
+
+#if !WIRE_MGR_FAMILY_DS18B20 && !WIRE_MGR_FAMILY_DS18S20 && !WIRE_MGR_FAMILY_DS1822
+#error "No sensor family enabled"
+#endif
+
+#ifndef WIRE_MGR_ROM_CACHE_ENABLED
+/*!
+ * \brief Enables keeping table of found sensors in EEPROM, so warm boot
+ * verifies stored sensors instead of searching the bus
+ */
+#define WIRE_MGR_ROM_CACHE_ENABLED  (0)
+#endif
+
+#ifndef WIRE_MGR_STATS_ENABLED
+/*!
+ * \brief Enables per sensor statistics given by \ref WIRE_MGR_get_stats,
+ * which are the largest part of device table entry
+ */
+#define WIRE_MGR_STATS_ENABLED      (1)
+#endif
+
+#ifndef WIRE_MGR_BENCH_ENABLED
+/*!
+ * \brief Enables measuring cycles of state handlers and other hot paths,
+ * results are reported with DEBUG as block of BENCH lines
+ *
+ * \warning Timer1 is configured as free running counter on initialization
+ * and must not be used by the application in benchmark build
+ */
+#define WIRE_MGR_BENCH_ENABLED      (0)
+#endif
+
+#if WIRE_MGR_BENCH_ENABLED
+#include <avr/io.h>
+
+#ifndef WIRE_MGR_BENCH_PRESCALER
+/*!
+ * \brief Prescaler of Timer1 while benchmarking, 1, 8 or 64, sets
+ * resolution and range of measured cycles
+ */
+#define WIRE_MGR_BENCH_PRESCALER    (8u)
+#endif
+
+#ifndef WIRE_MGR_BENCH_REPORT_SAMPLES
+/*!
+ * \brief Number of logged samples between benchmark reports
+ */
+#define WIRE_MGR_BENCH_REPORT_SAMPLES (16u)
+#endif
+
+#if WIRE_MGR_BENCH_PRESCALER == 1
+#define BENCH_CLOCK_SELECT          (1U << CS10)
+#elif WIRE_MGR_BENCH_PRESCALER == 8
+#define BENCH_CLOCK_SELECT          (1U << CS11)
+#elif WIRE_MGR_BENCH_PRESCALER == 64
+#define BENCH_CLOCK_SELECT          ((1U << CS11) | (1U << CS10))
+#else
+#error "Unsupported WIRE_MGR_BENCH_PRESCALER"
+#endif
+
+/*!
+ * \brief Number of calc_crc_block calls measured on initialization
+ */
+#define BENCH_CRC_RUNS              (16u)
+
+#define BENCH_START()               const uint16_t bench_count = TCNT1
+#define BENCH_STOP(entry)           bench_stop((entry), bench_count)
+
+/*!
+ * \brief Measured path of clocking of current transaction, scratchpad reads
+ * are measured separately
+ */
+#define BENCH_TRANSACTION_ENTRY()   ((bus->transaction.rx == bus->scratchpad.raw) ? \
+        BENCH_READ_SCRATCHPAD : BENCH_TRANSACTION)
+#else
+#define BENCH_START()               do {} while(0)
+#define BENCH_STOP(entry)           do {} while(0)
+#endif
+
+#ifndef WIRE_MGR_STATIC_CONFIG
+/*!
+ * \brief Makes crc checking, fake sensors handling and resolution compile
+ * time constants given by WIRE_MGR_CONFIG_IS_CRC,
+ * WIRE_MGR_CONFIG_IS_FAKE_ALLOWED and WIRE_MGR_CONFIG_RESOLUTION, so
+ * unused paths are dropped by compiler
+ */
+#define WIRE_MGR_STATIC_CONFIG      (0)
+#endif
+
+#if WIRE_MGR_STATIC_CONFIG
+#ifndef WIRE_MGR_CONFIG_IS_CRC
+#define WIRE_MGR_CONFIG_IS_CRC      (1)
+#endif
+
+#ifndef WIRE_MGR_CONFIG_IS_FAKE_ALLOWED
+#define WIRE_MGR_CONFIG_IS_FAKE_ALLOWED (0)
+#endif
+
+#ifndef WIRE_MGR_CONFIG_RESOLUTION
+#define WIRE_MGR_CONFIG_RESOLUTION  WIRE_12BIT_RESOLUTION
+#endif
+
+#if WIRE_MGR_CONFIG_RESOLUTION > WIRE_12BIT_RESOLUTION
+#error "Unsupported WIRE_MGR_CONFIG_RESOLUTION"
+#endif
+
+#define CONFIG_IS_CRC               ((bool)(WIRE_MGR_CONFIG_IS_CRC))
+#define CONFIG_IS_FAKE_ALLOWED      ((bool)(WIRE_MGR_CONFIG_IS_FAKE_ALLOWED))
+#define CONFIG_RESOLUTION           ((uint8_t)(WIRE_MGR_CONFIG_RESOLUTION))
+#define RESOLUTION_MASK             (get_resolution_mask(CONFIG_RESOLUTION))
+#define RESOLUTION_CONV_TIME        (get_resolution_conv_time(CONFIG_RESOLUTION))
+#else
+#define CONFIG_IS_CRC               (config.is_crc)
+#define CONFIG_IS_FAKE_ALLOWED      (config.is_fake_allowed)
+#define CONFIG_RESOLUTION           (config.resolution)
+#define RESOLUTION_MASK             (resolution_mask)
+#define RESOLUTION_CONV_TIME        (resolution_conv_time)
+#endif
+
+#define LOG_SUCCESS                 (WIRE_MGR_SUCCESS)
+#define LOG_CRC_ERROR               (WIRE_MGR_CRC_ERROR)
+#define LOG_NO_PRESENCE_ERROR       (WIRE_MGR_NO_PRESENCE_ERROR)
+#define LOG_FAKE_SENSOR_ERROR       (WIRE_MGR_FAKE_SENSOR_ERROR)
+#define LOG_CONFIG_ERROR            (WIRE_MGR_CONFIG_ERROR)
+#define LOG_SENTINEL                (5U)
 
 /*!
  *
@@ -95,6 +260,36 @@
 #define CONVERSION_TIME_12BIT       (750u)
 /*@}*/
 
+/*!
+ * \brief Time of copying scratchpad space to EEPROM of sensor
+ */
+#define COPY_SCRATCHPAD_TIME        (10u)
+
+/*!
+ *
+ * \addtogroup DS18B20_adaptive_resolution
+ * \ingroup 1wire_mgr
+ * \brief Thresholds of adaptive resolution, in raw temperature units
+ */
+/*@{*/
+#define ADAPTIVE_FAST_DELTA         (16u) /*!< change between samples dropping to 9 bit */
+#define ADAPTIVE_STABLE_DELTA       (2u) /*!< change between samples considered stable */
+#define ADAPTIVE_STABLE_COUNT       (4u) /*!< stable samples restoring resolution */
+/*@}*/
+
+/*!
+ *
+ * \addtogroup DS18B20_filter
+ * \ingroup 1wire_mgr
+ * \brief Parameters of readings filter
+ */
+/*@{*/
+#define POR_TEMPERATURE             (0x0550) /*!< power on reset value, 85 [C] */
+#define POR_ACCEPT_DELTA            (16) /*!< distance of filtered value accepting POR value */
+#define POR_ACCEPT_COUNT            (2u) /*!< POR values in a row accepted as reading */
+#define EMA_FRACTION_BITS           (3u) /*!< fractional bits of moving average */
+/*@}*/
+
 /*!
  * \brief Reserved value No1 for genuine DS1820 chips
  */
@@ -106,25 +301,97 @@
 #define RESERVED3_VALUE             (0x10u)
 
 /*!
- * \brief Family code for genuine DS1820 chips stored in ROM space
+ *
+ * \addtogroup DS18B20_family_codes
+ * \ingroup 1wire_mgr
+ * \brief Family codes of supported sensors stored in ROM space
+ */
+/*@{*/
+#define FAMILY_DS18B20              (0x28u)
+#define FAMILY_DS18S20              (0x10u)
+#define FAMILY_DS1822               (0x22u)
+/*@}*/
+
+/*!
+ * \brief Count per degree of DS18S20, fixed by the chip
  */
-#define FAMILY_CODE                 (0x28u)
+#define DS18S20_COUNT_PER_C         (16)
 
 /*!
  * \brief 1Wire mgr task period
  */
 #define TASK_PERIOD                 (1000u)
 
+/*!
+ * \brief 1Wire mgr task period in fast scheduling mode
+ */
+#define TASK_FAST_PERIOD            (10u)
+
+/*!
+ * \brief Maximal number of states handled in single task call in fast
+ * scheduling mode
+ */
+#define RUN_THROUGH_LIMIT           (WIRE_SENTINEL_STATE)
+
+/*!
+ * \brief Number of retries of failed identification state, before sensor
+ * is excluded from measurements
+ */
+#define IDENT_RETRY_LIMIT           (3u)
+
+/*!
+ * \brief Ticks after which sensors excluded on failed identification are
+ * identified again and bus in error state is searched again
+ */
+#define EXCLUDE_PERIOD              (10u * TASK_PERIOD)
+
+/*!
+ * \brief Number of rewrites of configuration not accepted by sensor, before
+ * sensor is excluded from measurements
+ */
+#define WRITE_RETRY_LIMIT           (2u)
+
+/*!
+ * \brief Number of scratchpad bytes holding temperature
+ */
+#define SCRATCHPAD_TEMP_SIZE        (2u)
+
+/*!
+ * \brief Version of layout of sensors table stored in EEPROM
+ */
+#define ROM_CACHE_VERSION           (0x01u)
+
+/*!
+ * \brief Dallas/Maxim crc8 polynomial x^8 + x^5 + x^4 + 1 in reflected form
+ */
+#define CRC_POLYNOMIAL              (0x8Cu)
+
+/*!
+ * \brief Number of bits in rom space
+ */
+#define ROM_CODE_BITS               (64u)
+
+/*!
+ * \brief Bus budget taken by single search pass, reset and command followed
+ * by triplets of read bits and written direction of each rom bit
+ */
+#define SEARCH_PASS_BUDGET          (2u + ((ROM_CODE_BITS * 3u) / CHAR_BIT))
+
 /*!
  * \brief States of 1Wire manager
  */
 typedef enum
 {
-    WIRE_READ_ROM, /*!< read rom space */
+    WIRE_SEARCH_ROM, /*!< search bus for rom spaces of sensors */
+    WIRE_READ_ROM, /*!< check rom space and power supply of handled sensor */
     WIRE_READ_SCRATCHPAD, /*!< read scratchpad space */
     WIRE_WRITE_SCRATCHPAD, /*!< write scratchpad space, configure sensor */
+    WIRE_COPY_SCRATCHPAD, /*!< copy configuration to EEPROM of sensor */
+    WAIT_FOR_COPY, /*!< wait till configuration is copied */
     START_CONVERSION, /*!< start temperature conversion */
     WAIT_FOR_CONVERTION, /*!< wait till conversion is finished */
+    WIRE_ALARM_SEARCH, /*!< search for sensors signalling alarm */
+    WIRE_DISCOVERY, /*!< search step for added and removed sensors */
     READ_CONVERSION_RESULT, /*!< read conversion result */
     LOG_CONVERSION_RESULT, /*!< log conversion results */
     WIRE_ERROR_STATE, /*!< error state */
@@ -177,16 +444,294 @@ typedef union
     uint8_t raw[8];
 } WIRE_rom_code_space_t;
 
-static WIRE_state_t state;
-static WIRE_state_t old_state = WIRE_SENTINEL_STATE;
-static bool is_sensor_ready;
-static uint8_t result;
-static uint8_t wire_mgr_log[LOG_SENTINEL];
-static int16_t temperature;
-static uint16_t conversion_time;
-static uint32_t start_conv_time;
-static WIRE_scratchpad_space_t scratchpad;
-static WIRE_rom_code_space_t rom_code;
+/*!
+ * \brief Structure represents statistics of sensor
+ */
+typedef struct
+{
+    uint32_t count[LOG_SENTINEL]; /*!< number of logged results per log code */
+    uint32_t bus_time_sum; /*!< sum of bus times of all results */
+    uint32_t latency_sum; /*!< sum of latencies of successful reads */
+    uint32_t retries; /*!< number of immediate re-reads of conversion result */
+    uint16_t bus_time_min; /*!< minimal bus time of result */
+    uint16_t bus_time_max; /*!< maximal bus time of result */
+    uint16_t latency_min; /*!< minimal latency of successful read */
+    uint16_t latency_max; /*!< maximal latency of successful read */
+} WIRE_stats_t;
+
+#if (WIRE_MGR_MEDIAN_SIZE == 0u) || (WIRE_MGR_MEDIAN_SIZE > 15u)
+#error "WIRE_MGR_MEDIAN_SIZE has to fit window bitfields"
+#endif
+
+#if (WIRE_MGR_SAMPLES_SIZE == 0u) || ((WIRE_MGR_SAMPLES_SIZE & (WIRE_MGR_SAMPLES_SIZE - 1u)) != 0u)
+#error "WIRE_MGR_SAMPLES_SIZE has to be power of two"
+#endif
+
+/*!
+ * \brief Structure represents sensor found on the bus
+ *
+ * \details Full scratchpad space is read into single buffer of the bus,
+ * from which temperature is taken and configuration register is checked
+ * against resolution. Rom space keeps its crc, so MATCH_ROM does not
+ * calculate it. Flags and small counters are packed into bitfields.
+ */
+typedef struct
+{
+    WIRE_rom_code_space_t rom_code; /*!< rom space of sensor */
+    int16_t temperature; /*!< last read temperature */
+    int8_t th; /*!< high alarm threshold */
+    int8_t tl; /*!< low alarm threshold */
+    bool is_valid : 1; /*!< sensor passed identification */
+    bool is_ready : 1; /*!< temperature is valid */
+    bool is_parasite : 1; /*!< sensor is parasite powered */
+    bool is_configured : 1; /*!< sensor has been configured with resolution */
+    bool is_written : 1; /*!< configuration has been written, read back pending */
+    bool is_alarm_set : 1; /*!< alarm thresholds set by user */
+    bool is_alarming : 1; /*!< sensor signalled alarm in last alarm search */
+    bool is_filtered : 1; /*!< filtered temperature is valid */
+    uint8_t resolution : 2; /*!< resolution of sensor */
+    uint8_t stable_count : 3; /*!< number of stable samples in a row */
+    uint8_t por_count : 2; /*!< rejected POR values in a row */
+    bool is_excluded : 1; /*!< identification failed, retried after \ref EXCLUDE_PERIOD */
+    uint8_t window_count : 4; /*!< number of readings in median window */
+    uint8_t window_pos : 4; /*!< position of next reading in median window */
+    int16_t filtered; /*!< filtered temperature, fixed point for EMA */
+    int16_t window[WIRE_MGR_MEDIAN_SIZE]; /*!< last readings of median filter */
+#if WIRE_MGR_STATS_ENABLED
+    uint16_t bus_time; /*!< time spent in handlers since last result */
+    WIRE_stats_t stats; /*!< statistics of sensor */
+#endif
+} WIRE_device_t;
+
+/*!
+ * \brief Structure represents state of ROM search algorithm
+ */
+typedef struct
+{
+    WIRE_rom_code_space_t rom_code; /*!< last found rom space */
+    uint8_t last_discrepancy; /*!< bit position of last discrepancy */
+    uint8_t last_family_discrepancy; /*!< bit position of last discrepancy within family code */
+    bool is_last_device; /*!< last device on the bus has been found */
+    bool is_started; /*!< search has been started with first supported family */
+    bool is_discrepancy; /*!< devices of different rom spaces responded */
+} WIRE_search_t;
+
+/*!
+ * \brief Structure represents driver of sensor family
+ *
+ * \details Configurable families have DS18B20 like configuration register
+ * setting resolution, conversion time and raw temperature format. The
+ * others convert in 9 bits, which are extended by count remain register.
+ */
+typedef struct
+{
+    uint8_t family_code; /*!< family code of rom space */
+    bool is_configurable; /*!< resolution is set by configuration register */
+} WIRE_family_t;
+
+/*!
+ * \brief Drivers of families enabled in the build
+ */
+static const WIRE_family_t families[] PROGMEM = {
+#if WIRE_MGR_FAMILY_DS18S20
+    { .family_code = FAMILY_DS18S20, .is_configurable = false },
+#endif
+#if WIRE_MGR_FAMILY_DS18B20
+    { .family_code = FAMILY_DS18B20, .is_configurable = true },
+#endif
+#if WIRE_MGR_FAMILY_DS1822
+    { .family_code = FAMILY_DS1822, .is_configurable = true },
+#endif
+};
+
+/*!
+ * \brief Structure represents table of sensors stored in EEPROM
+ */
+typedef struct
+{
+    uint8_t version; /*!< version of layout, \ref ROM_CACHE_VERSION */
+    uint8_t count; /*!< number of stored rom spaces */
+    uint8_t crc; /*!< crc of version, count and stored rom spaces */
+    WIRE_rom_code_space_t rom_codes[WIRE_MGR_MAX_DEVICES]; /*!< stored rom spaces */
+} WIRE_rom_cache_t;
+
+/*!
+ * \brief Structure represents 1Wire bus with its sensors and state machine
+ */
+typedef struct
+{
+    const WIRE_MGR_port_t *port; /*!< bus primitives of the bus */
+    WIRE_state_t state; /*!< current state */
+    WIRE_state_t old_state; /*!< previously handled state */
+    uint8_t result; /*!< result of last operation as log code */
+    uint16_t conversion_time; /*!< time of started conversion */
+    uint32_t start_conv_time; /*!< tick of conversion start */
+    uint32_t start_copy_time; /*!< tick of start of copying to EEPROM */
+    uint32_t start_round_time; /*!< tick of start of sampling round */
+    bool is_round_started; /*!< sampling round has been started */
+    uint32_t wakeup_time; /*!< tick of last handling in fast scheduling mode */
+    uint16_t wakeup_delay; /*!< delay of next handling in fast scheduling mode */
+    bool is_parasite_bus; /*!< any sensor is parasite powered */
+    bool is_transaction_pending; /*!< transaction has been started */
+    uint8_t power_supply; /*!< answer to READ_POWER_SUPPLY */
+    uint8_t rx_crc; /*!< crc of bytes read in transaction */
+    uint8_t transfer_pos; /*!< position of next reset or byte of blocking transaction */
+    WIRE_transaction_t transaction; /*!< transaction of current state */
+    WIRE_scratchpad_space_t scratchpad; /*!< last read scratchpad space */
+    WIRE_device_t devices[WIRE_MGR_MAX_DEVICES]; /*!< sensors found on the bus */
+    uint8_t devices_count; /*!< number of sensors found on the bus */
+    uint8_t current; /*!< index of handled sensor */
+    uint8_t retries; /*!< re-reads of conversion result of handled sensor */
+    uint8_t ident_retries; /*!< retries of failed identification of handled sensor */
+    uint8_t write_retries; /*!< rewrites of configuration of handled sensor */
+    uint32_t exclude_time; /*!< tick of last exclusion of sensor */
+    bool is_warm_boot; /*!< sensors loaded from EEPROM are being verified */
+    bool is_single_device; /*!< search found no other device, even of unsupported family */
+    WIRE_search_t search; /*!< state of search of current state */
+    bool is_search_pending; /*!< search yielded on bus budget, resumes on next call */
+    WIRE_search_t discovery; /*!< state of background search */
+    WIRE_rom_code_space_t found[WIRE_MGR_MAX_DEVICES]; /*!< rom spaces found by background search */
+    uint8_t found_count; /*!< number of rom spaces found by background search */
+} WIRE_bus_t;
+
+/*!
+ * \brief Primitives of default bus, provided by 1Wire driver
+ */
+static const WIRE_MGR_port_t default_port = {
+    .reset = WIRE_reset,
+    .send_byte = WIRE_send_byte,
+    .read_byte = WIRE_read_byte,
+    .send_bit = WIRE_send_bit,
+    .read_bit = WIRE_read_bit,
+    .set_strong_pullup = WIRE_set_strong_pullup,
+};
+
+static WIRE_MGR_config_t config;
+#if !WIRE_MGR_STATIC_CONFIG
+static uint8_t resolution_mask;
+static uint16_t resolution_conv_time;
+#endif
+static WIRE_bus_t buses[WIRE_MGR_MAX_BUSES];
+static uint8_t buses_count;
+static WIRE_bus_t *bus;
+static uint8_t bus_budget;
+static volatile WIRE_MGR_snapshot_t snapshots[2];
+static volatile uint8_t snapshot_seq;
+static WIRE_MGR_sample_t samples[WIRE_MGR_SAMPLES_SIZE];
+static uint16_t samples_seq;
+static WIRE_MGR_sample_cb_t sample_cb;
+#if WIRE_MGR_ROM_CACHE_ENABLED
+static WIRE_rom_cache_t rom_cache[WIRE_MGR_MAX_BUSES] EEMEM;
+#endif
+
+#if WIRE_MGR_BENCH_ENABLED
+/*!
+ * \brief Measured paths, state handlers take entries of their states
+ */
+enum
+{
+    BENCH_CRC_BLOCK = WIRE_SENTINEL_STATE, /*!< calc_crc_block over scratchpad space */
+    BENCH_TRANSACTION, /*!< blocking clocking of bus transaction */
+    BENCH_READ_SCRATCHPAD, /*!< blocking clocking of scratchpad read transaction */
+    BENCH_DECODE, /*!< check and decoding of read scratchpad space */
+    BENCH_MAIN, /*!< single call of task function */
+    BENCH_SAMPLE, /*!< task function calls per logged sample */
+    BENCH_SENTINEL,
+};
+
+/*!
+ * \brief Structure represents measurements of single path
+ */
+typedef struct
+{
+    uint32_t calls; /*!< number of measured calls */
+    uint32_t sum; /*!< sum of cycles of all calls */
+    uint32_t max; /*!< cycles of the longest call */
+} WIRE_bench_t;
+
+static WIRE_bench_t bench[BENCH_SENTINEL];
+static uint32_t bench_sample_sum;
+static bool bench_is_sampled;
+static uint8_t bench_samples;
+
+/*!
+ * \brief Adds measurement of path
+ *
+ * \param entry measured path
+ * \param cycles cycles of the call
+ */
+static void bench_record(uint8_t entry, uint32_t cycles)
+{
+    WIRE_bench_t *b = &bench[entry];
+
+    b->calls++;
+    b->sum += cycles;
+
+    if(cycles > b->max)
+    {
+        b->max = cycles;
+    }
+}
+
+/*!
+ * \brief Finishes measurement of path
+ *
+ * \note Single call can't take more than 65536 Timer1 counts
+ *
+ * \param entry measured path
+ * \param start value of Timer1 at start of the call
+ */
+static void bench_stop(uint8_t entry, uint16_t start)
+{
+    const uint16_t counts = (uint16_t)(TCNT1 - start);
+
+    bench_record(entry, (uint32_t)counts * WIRE_MGR_BENCH_PRESCALER);
+}
+
+/*!
+ * \brief Reports measurements as single block of BENCH lines
+ *
+ * \details Block starts with BENCH,begin,report number line, paths follow as
+ * BENCH,name,calls,avg,max lines in cycles, then BENCH,ram and BENCH,device
+ * lines in bytes and BENCH,end line. State handlers are named by their
+ * functions. Paths are measured again from the next report, except of
+ * calc_crc_block measured only on initialization.
+ */
+static void bench_report(void)
+{
+    static const char *const names[BENCH_SENTINEL] = {
+        "handle_search_rom", "handle_read_rom", "handle_read_scratchpad",
+        "handle_write_scratchpad", "handle_copy_scratchpad", "handle_wait_for_copy",
+        "handle_start_conversion", "handle_wait_for_conversion", "handle_alarm_search",
+        "handle_discovery", "handle_read_conversion_results",
+        "handle_log_conversion_results", "handle_error_state",
+        "calc_crc_block", "transaction", "read_scratchpad_bytes", "decode",
+        "wire_mgr_main", "sample",
+    };
+    static uint16_t reports;
+
+    reports++;
+    DEBUG(DL_INFO, "BENCH,begin,%u\n", reports);
+    DEBUG(DL_INFO, "%s\n", "BENCH,name,calls,avg,max");
+
+    for(uint8_t i = 0U; i < BENCH_SENTINEL; i++)
+    {
+        const WIRE_bench_t *b = &bench[i];
+        const uint32_t avg = (b->calls != 0U) ? (b->sum / b->calls) : 0U;
+
+        DEBUG(DL_INFO, "BENCH,%s,%lu,%lu,%lu\n", names[i], b->calls, avg, b->max);
+    }
+
+    DEBUG(DL_INFO, "BENCH,ram,%u\n", (unsigned)(sizeof(config) + sizeof(buses) +
+                sizeof(snapshots) + sizeof(samples)));
+    DEBUG(DL_INFO, "BENCH,device,%u\n", (unsigned)sizeof(WIRE_device_t));
+    DEBUG(DL_INFO, "%s\n", "BENCH,end");
+
+    memset(bench, 0, sizeof(bench[0]) * BENCH_CRC_BLOCK);
+    memset(&bench[BENCH_TRANSACTION], 0,
+            sizeof(bench[0]) * (BENCH_SENTINEL - BENCH_TRANSACTION));
+}
+#endif
 
 /*!
  * \brief Checks whatever reserved values are valid as for genuine sensor
@@ -220,6 +765,109 @@ static inline int16_t get_temperature(uint8_t msb, uint8_t lsb)
     return (int16_t)(((uint16_t)msb << CHAR_BIT) | lsb);
 }
 
+/*!
+ * \brief Finds driver of given family
+ *
+ * \param family_code family code of rom space
+ * \param family storage for driver
+ *
+ * \retval true family is enabled in the build
+ * \retval false family is not supported
+ */
+static bool get_family(uint8_t family_code, WIRE_family_t *family)
+{
+    for(uint8_t i = 0U; i < sizeof(families)/sizeof(families[0]); i++)
+    {
+        memcpy_P(family, &families[i], sizeof(*family));
+
+        if(family->family_code == family_code)
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/*!
+ * \brief Checks whatever resolution of sensor is set by configuration
+ * register
+ *
+ * \details Sensors of unsupported family, allowed as fake, are handled as
+ * DS18B20
+ *
+ * \param dev sensor
+ *
+ * \retval true sensor is configurable
+ * \retval false sensor converts with fixed resolution
+ */
+static bool is_configurable(const WIRE_device_t *dev)
+{
+    WIRE_family_t family;
+
+    return !get_family(dev->rom_code.family_code, &family) || family.is_configurable;
+}
+
+/*!
+ * \brief Gets resolution handled sensor is converted with
+ *
+ * \details Extended 9 bit reading has 1/16 [C] quantum and 750 [ms]
+ * conversion time, as 12 bit reading has
+ *
+ * \param dev sensor
+ *
+ * \returns configured resolution for configurable sensor, 12 bit otherwise
+ */
+static inline uint8_t get_family_resolution(const WIRE_device_t *dev)
+{
+    return is_configurable(dev) ? CONFIG_RESOLUTION : WIRE_12BIT_RESOLUTION;
+}
+
+/*!
+ * \brief Gets order of family code in ROM search
+ *
+ * \details Search walks rom bits from the least significant one, taking 0
+ * branch first, so families are found in order of bit reversed codes
+ *
+ * \param family_code family code
+ *
+ * \returns bit reversed family code
+ */
+static uint8_t get_family_order(uint8_t family_code)
+{
+    uint8_t ret = 0U;
+
+    for(uint8_t i = 0U; i < CHAR_BIT; i++)
+    {
+        ret = (uint8_t)((ret << 1U) | ((family_code >> i) & 0x01U));
+    }
+
+    return ret;
+}
+
+/*!
+ * \brief Decodes temperature of handled sensor from scratchpad space
+ *
+ * \returns raw temperature in 1/16 [C] units
+ */
+static int16_t decode_temperature(void)
+{
+    const WIRE_scratchpad_space_t *scratchpad = &bus->scratchpad;
+    const int16_t raw = get_temperature(scratchpad->temp_msb, scratchpad->temp_lsb);
+
+#if WIRE_MGR_FAMILY_DS18S20
+    if(!is_configurable(&bus->devices[bus->current]))
+    {
+        /* T = T_READ - 0.25 + (COUNT_PER_C - COUNT_REMAIN) / COUNT_PER_C,
+         * count remain is held in reserved2 byte */
+        return (int16_t)(((raw & (int16_t)~1) * 8) - 4 +
+                (DS18S20_COUNT_PER_C - (int16_t)scratchpad->reserved2));
+    }
+#endif
+
+    return raw;
+}
+
 /*!
  * \brief Gets convertion time for given resolution
  *
@@ -275,46 +923,145 @@ static inline uint8_t get_resolution_mask(uint8_t resolution)
 }
 
 /*!
- * \brief Calculates crc for given initial crc and data
+ * \brief Checks whatever configuration is valid
  *
- * \param crc initial crc
- * \param data data to be included in crc calculation
+ * \param cfg configuration to be checked
  *
- * \returns calculated crc
+ * \retval true configuration is valid
+ * \retval false configuration is invalid
  */
-static uint8_t calc_crc(uint8_t crc, uint8_t data)
+static bool is_config_valid(const WIRE_MGR_config_t *cfg)
 {
-    /* https://www.maximintegrated.com/en/app-notes/index.mvp/id/27 */
-    static const uint8_t table[256] PROGMEM = {
-            0, 94, 188, 226, 97, 63, 221, 131, 194, 156, 126, 32, 163, 253, 31, 65,
-            157, 195, 33, 127, 252, 162, 64, 30, 95, 1, 227, 189, 62, 96, 130, 220,
-            35, 125, 159, 193, 66, 28, 254, 160, 225, 191, 93, 3, 128, 222, 60, 98,
-            190, 224, 2, 92, 223, 129, 99, 61, 124, 34, 192, 158, 29, 67, 161, 255,
-            70, 24, 250, 164, 39, 121, 155, 197, 132, 218, 56, 102, 229, 187, 89, 7,
-            219, 133, 103, 57, 186, 228, 6, 88, 25, 71, 165, 251, 120, 38, 196, 154,
-            101, 59, 217, 135, 4, 90, 184, 230, 167, 249, 27, 69, 198, 152, 122, 36,
-            248, 166, 68, 26, 153, 199, 37, 123, 58, 100, 134, 216, 91, 5, 231, 185,
-            140, 210, 48, 110, 237, 179, 81, 15, 78, 16, 242, 172, 47, 113, 147, 205,
-            17, 79, 173, 243, 112, 46, 204, 146, 211, 141, 111, 49, 178, 236, 14, 80,
-            175, 241, 19, 77, 206, 144, 114, 44, 109, 51, 209, 143, 12, 82, 176, 238,
-            50, 108, 142, 208, 83, 13, 239, 177, 240, 174, 76, 18, 145, 207, 45, 115,
-            202, 148, 118, 40, 171, 245, 23, 73, 8, 86, 180, 234, 105, 55, 213, 139,
-            87, 9, 235, 181, 54, 104, 138, 212, 149, 203, 41, 119, 244, 170, 72, 22,
-            233, 183, 85, 11, 136, 214, 52, 106, 43, 117, 151, 201, 74, 20, 246, 168,
-            116, 42, 200, 150, 21, 75, 169, 247, 182, 232, 10, 84, 215, 137, 107, 53
-    };
+    return (cfg->resolution <= WIRE_12BIT_RESOLUTION) &&
+        (cfg->filter <= WIRE_MGR_FILTER_MEDIAN);
+}
 
-    return pgm_read_byte(&table[crc ^ data]);
+/*!
+ * \brief Recomputes values derived from configuration
+ */
+static void apply_config(void)
+{
+#if WIRE_MGR_STATIC_CONFIG
+    config.is_crc = CONFIG_IS_CRC;
+    config.is_fake_allowed = CONFIG_IS_FAKE_ALLOWED;
+    config.resolution = CONFIG_RESOLUTION;
+#else
+    resolution_mask = get_resolution_mask(config.resolution);
+    resolution_conv_time = get_resolution_conv_time(config.resolution);
+#endif
 }
 
 /*!
- * \brief Calculates crc for given buffer
+ * \brief Gets configuration register mask of given sensor
  *
- * \param crc initial crc
- * \param buffer block of data over which crc is going to be calculated
- * \param length length of data block
+ * \param dev sensor
  *
- * \returns calculated crc
+ * \returns resolution mask
+ */
+static inline uint8_t get_device_mask(const WIRE_device_t *dev)
+{
+    if(dev->resolution == CONFIG_RESOLUTION)
+    {
+        return RESOLUTION_MASK;
+    }
+
+    return get_resolution_mask(dev->resolution);
+}
+
+/*!
+ * \brief Gets conversion time of given sensor
+ *
+ * \param dev sensor
+ *
+ * \returns conversion time
+ */
+static inline uint16_t get_device_conv_time(const WIRE_device_t *dev)
+{
+    if(dev->resolution == CONFIG_RESOLUTION)
+    {
+        return RESOLUTION_CONV_TIME;
+    }
+
+    return get_resolution_conv_time(dev->resolution);
+}
+
+/*!
+ * \brief Gets quantum of temperature for given resolution
+ *
+ * \param resolution resolution for getting quantum
+ *
+ * \returns value of least significant defined bit of raw temperature
+ */
+static inline int16_t get_resolution_quantum(uint8_t resolution)
+{
+    return (int16_t)(1U << (WIRE_12BIT_RESOLUTION - resolution));
+}
+
+/*!
+ * \brief Calculates crc for given initial crc and data
+ *
+ * \param crc initial crc
+ * \param data data to be included in crc calculation
+ *
+ * \returns calculated crc
+ */
+static uint8_t calc_crc(uint8_t crc, uint8_t data)
+{
+    /* https://www.maximintegrated.com/en/app-notes/index.mvp/id/27 */
+#if WIRE_MGR_CRC_ENGINE == WIRE_MGR_CRC_TABLE
+    static const uint8_t table[256] PROGMEM = {
+            0, 94, 188, 226, 97, 63, 221, 131, 194, 156, 126, 32, 163, 253, 31, 65,
+            157, 195, 33, 127, 252, 162, 64, 30, 95, 1, 227, 189, 62, 96, 130, 220,
+            35, 125, 159, 193, 66, 28, 254, 160, 225, 191, 93, 3, 128, 222, 60, 98,
+            190, 224, 2, 92, 223, 129, 99, 61, 124, 34, 192, 158, 29, 67, 161, 255,
+            70, 24, 250, 164, 39, 121, 155, 197, 132, 218, 56, 102, 229, 187, 89, 7,
+            219, 133, 103, 57, 186, 228, 6, 88, 25, 71, 165, 251, 120, 38, 196, 154,
+            101, 59, 217, 135, 4, 90, 184, 230, 167, 249, 27, 69, 198, 152, 122, 36,
+            248, 166, 68, 26, 153, 199, 37, 123, 58, 100, 134, 216, 91, 5, 231, 185,
+            140, 210, 48, 110, 237, 179, 81, 15, 78, 16, 242, 172, 47, 113, 147, 205,
+            17, 79, 173, 243, 112, 46, 204, 146, 211, 141, 111, 49, 178, 236, 14, 80,
+            175, 241, 19, 77, 206, 144, 114, 44, 109, 51, 209, 143, 12, 82, 176, 238,
+            50, 108, 142, 208, 83, 13, 239, 177, 240, 174, 76, 18, 145, 207, 45, 115,
+            202, 148, 118, 40, 171, 245, 23, 73, 8, 86, 180, 234, 105, 55, 213, 139,
+            87, 9, 235, 181, 54, 104, 138, 212, 149, 203, 41, 119, 244, 170, 72, 22,
+            233, 183, 85, 11, 136, 214, 52, 106, 43, 117, 151, 201, 74, 20, 246, 168,
+            116, 42, 200, 150, 21, 75, 169, 247, 182, 232, 10, 84, 215, 137, 107, 53
+    };
+
+    return pgm_read_byte(&table[crc ^ data]);
+#elif WIRE_MGR_CRC_ENGINE == WIRE_MGR_CRC_NIBBLE
+    /* crc is linear, so table entry is xor of entries of both nibbles */
+    static const uint8_t table_lo[16] PROGMEM = {
+            0, 94, 188, 226, 97, 63, 221, 131, 194, 156, 126, 32, 163, 253, 31, 65
+    };
+    static const uint8_t table_hi[16] PROGMEM = {
+            0, 157, 35, 190, 70, 219, 101, 248, 140, 17, 175, 50, 202, 87, 233, 116
+    };
+    const uint8_t idx = crc ^ data;
+
+    return pgm_read_byte(&table_lo[idx & 0x0FU]) ^ pgm_read_byte(&table_hi[idx >> 4U]);
+#elif WIRE_MGR_CRC_ENGINE == WIRE_MGR_CRC_BITWISE
+    uint8_t ret = crc ^ data;
+
+    for(uint8_t i = 0U; i < CHAR_BIT; i++)
+    {
+        ret = (ret & 0x01U) ? (uint8_t)((ret >> 1U) ^ CRC_POLYNOMIAL) : (uint8_t)(ret >> 1U);
+    }
+
+    return ret;
+#else
+#error "Unsupported WIRE_MGR_CRC_ENGINE"
+#endif
+}
+
+/*!
+ * \brief Calculates crc for given buffer
+ *
+ * \param crc initial crc
+ * \param buffer block of data over which crc is going to be calculated
+ * \param length length of data block
+ *
+ * \returns calculated crc
  */
 static uint8_t calc_crc_block(uint8_t crc, const uint8_t * buffer, size_t length)
 {
@@ -322,14 +1069,12 @@ static uint8_t calc_crc_block(uint8_t crc, const uint8_t * buffer, size_t length
     size_t len = length;
     uint8_t ret = crc;
 
-    do
+    while(len-- > 0U)
     {
         ret = calc_crc(ret, *buff);
         DEBUG(DL_VERBOSE, "buffer 0x%02x, crc 0x%02x, len %d\n", *buff, ret, len);
         buff++;
-        len--;
     }
-    while (len > 0);
 
     return ret;
 }
@@ -359,295 +1104,2192 @@ static bool is_crc_valid(const uint8_t *buffer, uint8_t size, uint8_t exp_crc)
 }
 
 /*!
- * \brief Reads bytes from 1Wire interface
+ * \brief Checks crc over data block ended with its crc
+ *
+ * \details Crc calculated over data and its crc is zero, so whole block
+ * can be checked in single pass
  *
- * \param buffer output storage for read data
- * \param size size of output storage
+ * \param crc crc calculated over data block and its crc
+ *
+ * \retval true crc is valid
+ * \retval false crc is invalid
  */
-static void read_bytes(uint8_t *buffer, uint8_t size)
+static bool is_block_crc_valid(uint8_t crc)
 {
-    for(uint8_t i = 0U; i < size; i++)
+    if(crc != 0U)
     {
-        buffer[i] = WIRE_read_byte();
+        DEBUG(DL_ERROR, "CRC error residue 0x%02x\n", crc);
+        return false;
     }
 
-    DEBUG_DUMP_HEX(DL_DEBUG, buffer, size);
+    return true;
 }
 
 /*!
- * \brief Reads scratchpad space of sensor
+ * \brief Checks whatever sensors loaded from EEPROM are being verified
+ *
+ * \retval true warm boot is in progress
+ * \retval false sensors have been found by search or verified already
  */
-static void read_scratchpad_bytes(void)
+static inline bool is_warm_boot(void)
 {
-    const uint8_t scratchpad_size =
-        sizeof(scratchpad.raw)/sizeof(scratchpad.raw[0]);
-
-    WIRE_send_byte(SKIP_ROM);
-    WIRE_send_byte(READ_SCRATCHPAD);
-
-    read_bytes(scratchpad.raw, scratchpad_size);
-
-    DEBUG_DUMP_HEX(DL_DEBUG, scratchpad.raw, scratchpad_size);
+#if WIRE_MGR_ROM_CACHE_ENABLED
+    return bus->is_warm_boot;
+#else
+    return false;
+#endif
 }
 
 /*!
- * \brief Handles \ref WIRE_READ_ROM state
+ * \brief Checks whatever crc of read bytes is checked
  *
- * \returns next state
+ * \details Crc is the proof, that sensor loaded from EEPROM answered, so
+ * it is checked during warm boot regardless of configuration
+ *
+ * \retval true crc is checked
+ * \retval false crc is not checked
  */
-static WIRE_state_t handle_read_rom(void)
+static inline bool is_crc_checked(void)
 {
-    const bool is_crc = pgm_read_byte(&wire_mgr_config.is_crc);
-    const uint8_t rom_code_size =
-        sizeof(rom_code.raw)/sizeof(rom_code.raw[0]);
-
-    WIRE_send_byte(READ_ROM);
-
-    read_bytes(rom_code.raw, rom_code_size);
-
-    if(is_crc && !is_crc_valid(rom_code.raw, rom_code_size - 1U, rom_code.crc))
-    {
-        result = LOG_CRC_ERROR;
-        return LOG_CONVERSION_RESULT;
-    }
-
-    if((rom_code.family_code != FAMILY_CODE) ||
-            (rom_code.serial_no[4] != 0U) ||
-            (rom_code.serial_no[5] != 0U))
-    {
-        const bool is_fake_allowed  = pgm_read_byte(&wire_mgr_config.is_fake_allowed);
-
-        DEBUG(is_fake_allowed ? DL_WARNING: DL_ERROR, "%s\n", "Invalid ROM code");
+    return CONFIG_IS_CRC || is_warm_boot();
+}
 
-        if(!is_fake_allowed)
-        {
-            result = LOG_FAKE_SENSOR_ERROR;
-            return LOG_CONVERSION_RESULT;
-        }
-    }
+/*!
+ * \brief Begins new transaction
+ */
+static void begin_transaction(void)
+{
+    bus->transaction.tx_len = 0U;
+    bus->transaction.rx = NULL;
+    bus->transaction.rx_len = 0U;
+    bus->transaction.is_pullup = false;
+    bus->transaction.is_abort = false;
+}
 
-    return WIRE_READ_SCRATCHPAD;
+/*!
+ * \brief Adds byte to be sent in transaction
+ *
+ * \param byte byte to be sent
+ */
+static void add_tx_byte(uint8_t byte)
+{
+    ASSERT(bus->transaction.tx_len < WIRE_TRANSACTION_TX_SIZE);
+    bus->transaction.tx[bus->transaction.tx_len] = byte;
+    bus->transaction.tx_len++;
 }
 
 /*!
- * \brief Handles \ref WIRE_READ_ROM state
+ * \brief Sets storage for bytes read in transaction
  *
- * \returns next state
+ * \param buffer storage for read bytes
+ * \param size number of bytes to be read
  */
-static WIRE_state_t handle_read_scratchpad(void)
+static void set_rx_buffer(uint8_t *buffer, uint8_t size)
 {
-    const bool is_crc = pgm_read_byte(&wire_mgr_config.is_crc);
-    const uint8_t scratchpad_size =
-        sizeof(scratchpad.raw)/sizeof(scratchpad.raw[0]);
+    bus->transaction.rx = buffer;
+    bus->transaction.rx_len = size;
+}
 
-    read_scratchpad_bytes();
+/*!
+ * \brief Addresses handled sensor with ROM command in transaction
+ *
+ * \note If search found the sensor to be the only device on the bus SKIP_ROM
+ * is used, which saves 64 write slots of MATCH_ROM. Devices of unsupported
+ * families skipped by the search would answer SKIP_ROM too. Sensors loaded
+ * on warm boot are always matched, as they have to be verified to be the
+ * stored ones.
+ */
+static void add_select(void)
+{
+    const WIRE_rom_code_space_t *rom_code = &bus->devices[bus->current].rom_code;
+    const uint8_t rom_code_size = sizeof(rom_code->raw)/sizeof(rom_code->raw[0]);
 
-    if(is_crc && !is_crc_valid(scratchpad.raw, (scratchpad_size - 1U), scratchpad.crc))
+    if(bus->is_single_device)
     {
-        result = LOG_CRC_ERROR;
-        return LOG_CONVERSION_RESULT;
+        add_tx_byte(SKIP_ROM);
+        return;
     }
 
-    if(!is_reserved_values_valid(scratchpad.reserved1, scratchpad.reserved3))
-    {
-        const bool is_fake_allowed  = pgm_read_byte(&wire_mgr_config.is_fake_allowed);
-
-        DEBUG(is_fake_allowed ? DL_WARNING: DL_ERROR, "%s\n", "Invalid reserved bytes");
+    add_tx_byte(MATCH_ROM);
 
-        if(!is_fake_allowed)
-        {
-            result = LOG_FAKE_SENSOR_ERROR;
-            return LOG_CONVERSION_RESULT;
-        }
+    for(uint8_t i = 0U; i < rom_code_size; i++)
+    {
+        add_tx_byte(rom_code->raw[i]);
     }
-
-    temperature = get_temperature(scratchpad.temp_msb, scratchpad.temp_lsb);
-
-    return WIRE_WRITE_SCRATCHPAD;
 }
 
 /*!
- * \brief Handles \ref WIRE_WRITE_SCRATCHPAD state
+ * \brief Checks whatever transactions of handled bus are clocked by
+ * \ref WIRE_async_start engine
  *
- * \returns next state
- */
-static WIRE_state_t handle_write_scratchpad(void)
-{
-    const uint8_t resolution = pgm_read_byte(&wire_mgr_config.resolution);
-
-    WIRE_send_byte(SKIP_ROM);
-    WIRE_send_byte(WRITE_SCRATCHPAD);
-    WIRE_send_byte(scratchpad.th);
-    WIRE_send_byte(scratchpad.tl);
-    WIRE_send_byte(get_resolution_mask(resolution));
-    /* \todo (DB) here should be read back of register */
-    return START_CONVERSION;
-}
-
-/*!
- * \brief Handles \ref START_CONVERSION state
+ * \details There is single engine, it drives the default bus, other buses
+ * are clocked in blocking way
  *
- * \returns next state
+ * \retval true transactions are clocked in background
+ * \retval false transactions are clocked in blocking way
  */
-static WIRE_state_t handle_start_conversion(void)
+static inline bool is_async_bus(void)
 {
-    WIRE_send_byte(SKIP_ROM);
-    WIRE_send_byte(CONVERT_T);
-    start_conv_time = SYSTEM_timer_get_tick();
-    return WAIT_FOR_CONVERTION;
+#if WIRE_MGR_ASYNC_ENABLED
+    return (bus == &buses[0]);
+#else
+    return false;
+#endif
 }
 
 /*!
- * \brief Handles \ref WAIT_FOR_CONVERTION state
+ * \brief Takes single reset or byte from bus budget of task call
  *
- * \returns next state
+ * \note Yielded transaction or search resumes on the next task call, which
+ * in classic scheduling is whole \ref TASK_PERIOD later
+ *
+ * \retval true reset or byte can be clocked
+ * \retval false budget is used up, transaction continues in next call
  */
-static WIRE_state_t handle_wait_for_conversion(void)
+static bool take_bus_budget(void)
 {
-    if(SYSTEM_timer_tick_difference(start_conv_time,
-                SYSTEM_timer_get_tick()) > conversion_time)
+    if(config.bus_budget == 0U)
     {
-        return READ_CONVERSION_RESULT;
+        return true;
     }
 
-    return WAIT_FOR_CONVERTION;
+    if(bus_budget == 0U)
+    {
+        return false;
+    }
+
+    bus_budget--;
+    return true;
 }
 
 /*!
- * \brief Handles \ref READ_CONVERSION_RESULT state
+ * \brief Takes search pass from bus budget of task call
  *
- * \returns next state
+ * \details Pass is clocked as a whole, so it is started if any budget is
+ * left and the rest of its cost is taken from what remains
+ *
+ * \retval true search pass can be clocked
+ * \retval false budget is used up, search continues in next call
  */
-static WIRE_state_t handle_read_conversion_results(void)
+static bool take_search_budget(void)
 {
-    const bool is_crc = pgm_read_byte(&wire_mgr_config.is_crc);
-    const uint8_t scratchpad_size =
-        sizeof(scratchpad.raw)/sizeof(scratchpad.raw[0]);
-
-    read_scratchpad_bytes();
+    if(config.bus_budget == 0U)
+    {
+        return true;
+    }
 
-    if(is_crc && !is_crc_valid(scratchpad.raw, (scratchpad_size - 1U), scratchpad.crc))
+    if(bus_budget == 0U)
     {
-        result = LOG_CRC_ERROR;
-        return LOG_CONVERSION_RESULT;
+        return false;
     }
 
-    temperature = get_temperature(scratchpad.temp_msb, scratchpad.temp_lsb);
-    result = LOG_SUCCESS;
-    is_sensor_ready = true;
-    return LOG_CONVERSION_RESULT;
+    bus_budget = (bus_budget > SEARCH_PASS_BUDGET) ? (uint8_t)(bus_budget - SEARCH_PASS_BUDGET) : 0U;
+    return true;
 }
 
 /*!
- * \brief Handles \ref LOG_CONVERSION_RESULT state
+ * \brief Clocks transaction on the bus in blocking way
  *
- * \returns next state
+ * \details Transaction is clocked till bus budget of task call is used up
+ * and continued by next call. Reset and bytes are clocked as a whole, so
+ * transfer yields only between bytes, where the bus idles. Strong pullup is
+ * enabled straight after the last sent byte and transfer aborting reset
+ * follows the last read byte. Crc is updated after each byte, between read
+ * slots of the bus, so it is ready once last byte is read.
  */
-static WIRE_state_t handle_log_conversion_results(void)
+static void execute_transaction(void)
 {
-    switch(result)
+    WIRE_transaction_t *t = &bus->transaction;
+    const uint8_t rx_pos = (uint8_t)(t->tx_len + 1U);
+    const uint8_t end_pos = (uint8_t)(rx_pos + t->rx_len);
+
+    while(bus->transfer_pos < end_pos)
     {
-        case LOG_SUCCESS:
-            DEBUG(DL_INFO, "1WIRE: 0x%04x[raw] %d.%04d[C]\n", temperature,
-                    temperature >> 4U, (temperature & 0xFu)*625u);
-            wire_mgr_log[LOG_SUCCESS]++;
-            break;
-        case LOG_CRC_ERROR:
-            DEBUG(DL_WARNING, "%s", "CRC error\n");
-            wire_mgr_log[LOG_CRC_ERROR]++;
-            break;
-        case LOG_NO_PRESENCE_ERROR:
-            DEBUG(DL_WARNING, "%s", "No Presence\n");
-            wire_mgr_log[LOG_NO_PRESENCE_ERROR]++;
-            break;
-        case LOG_FAKE_SENSOR_ERROR:
-            DEBUG(DL_ERROR, "%s", "Fake sensor\n");
-            wire_mgr_log[LOG_FAKE_SENSOR_ERROR]++;
-            break;
-        default:
-            ASSERT(false);
+        const uint8_t pos = bus->transfer_pos;
+
+        if(!take_bus_budget())
+        {
+            return;
+        }
+
+        if(pos == 0U)
+        {
+            t->is_presence = bus->port->reset();
+
+            if(!t->is_presence)
+            {
+                t->is_done = true;
+                return;
+            }
+
+            bus->rx_crc = 0U;
+        }
+        else if(pos < rx_pos)
+        {
+            bus->port->send_byte(t->tx[pos - 1U]);
+
+            if(t->is_pullup && (pos == t->tx_len))
+            {
+                bus->port->set_strong_pullup(true);
+            }
+        }
+        else
+        {
+            const uint8_t i = pos - rx_pos;
+
+            t->rx[i] = bus->port->read_byte();
+
+            if(is_crc_checked())
+            {
+                bus->rx_crc = calc_crc(bus->rx_crc, t->rx[i]);
+            }
+        }
+
+        bus->transfer_pos++;
     }
 
-    DEBUG(DL_INFO, "OK[%d] CRC[%d] PRE[%d] FAKE[%d]\n",
-            wire_mgr_log[0], wire_mgr_log[1], wire_mgr_log[2], wire_mgr_log[3]);
+    if(t->rx_len != 0U)
+    {
+        DEBUG_DUMP_HEX(DL_DEBUG, t->rx, t->rx_len);
+    }
 
-    switch(old_state)
+    if(t->is_abort)
     {
-        case WIRE_SENTINEL_STATE:
-        case WIRE_READ_ROM:
-            return (result == LOG_FAKE_SENSOR_ERROR ? WIRE_ERROR_STATE: WIRE_READ_ROM);
-        default:
-            return START_CONVERSION;
+        (void)bus->port->reset();
     }
+
+    t->is_done = true;
 }
 
 /*!
- * \brief Handles \ref WIRE_ERROR_STATE state
+ * \brief Starts prepared transaction
  *
- * \returns next state
+ * \note In blocking mode without bus budget transaction is finished on
+ * return
  */
-static WIRE_state_t handle_error_state(void)
+static void start_transaction(void)
 {
-    is_sensor_ready = false;
-    return WIRE_ERROR_STATE;
+    bus->transaction.is_done = false;
+    bus->is_transaction_pending = true;
+#if WIRE_MGR_ASYNC_ENABLED
+    if(is_async_bus())
+    {
+        WIRE_async_start(&bus->transaction);
+        return;
+    }
+#endif
+    bus->transfer_pos = 0U;
+    BENCH_START();
+    execute_transaction();
+    BENCH_STOP(BENCH_TRANSACTION_ENTRY());
 }
 
 /*!
- * \brief Handles states, which need sensor reset
+ * \brief Finds next rom space on the bus
  *
- * \param s state to be handled
+ * \param search state of search algorithm, zeroed before first call
+ * \param cmd ROM command starting search
  *
- * \returns next state
+ * \retval true next rom space found and stored in search state
+ * \retval false no more devices or no device responded
  */
-static WIRE_state_t handle_reset_needed_state(WIRE_state_t s)
+static bool search_next(WIRE_search_t *search, uint8_t cmd)
 {
-    if(WIRE_reset())
+    /* https://www.maximintegrated.com/en/app-notes/index.mvp/id/187 */
+    uint8_t last_zero = 0U;
+
+    if(search->is_last_device || !bus->port->reset())
     {
-        switch(s)
+        return false;
+    }
+
+    bus->port->send_byte(cmd);
+
+    for(uint8_t bit = 1U; bit <= ROM_CODE_BITS; bit++)
+    {
+        const uint8_t byte = (bit - 1U) / CHAR_BIT;
+        const uint8_t mask = (uint8_t)(1U << ((bit - 1U) % CHAR_BIT));
+        const bool id_bit = bus->port->read_bit();
+        const bool cmp_id_bit = bus->port->read_bit();
+        bool direction;
+
+        if(id_bit && cmp_id_bit)
         {
-            case WIRE_READ_ROM:
-                return handle_read_rom();
-            case WIRE_READ_SCRATCHPAD:
-                return handle_read_scratchpad();
-            case WIRE_WRITE_SCRATCHPAD:
-                return handle_write_scratchpad();
-            case START_CONVERSION:
-                return handle_start_conversion();
-            case READ_CONVERSION_RESULT:
-                return handle_read_conversion_results();
-            default:
-                ASSERT(false);
-                break;
+            return false;
         }
 
-        return WIRE_READ_ROM;
+        if(id_bit != cmp_id_bit)
+        {
+            direction = id_bit;
+        }
+        else
+        {
+            search->is_discrepancy = true;
+
+            if(bit < search->last_discrepancy)
+            {
+                direction = ((search->rom_code.raw[byte] & mask) != 0U);
+            }
+            else
+            {
+                direction = (bit == search->last_discrepancy);
+            }
+
+            if(!direction)
+            {
+                last_zero = bit;
+
+                if(bit <= CHAR_BIT)
+                {
+                    search->last_family_discrepancy = bit;
+                }
+            }
+        }
+
+        if(direction)
+        {
+            search->rom_code.raw[byte] |= mask;
+        }
+        else
+        {
+            search->rom_code.raw[byte] &= (uint8_t)~mask;
+        }
+
+        bus->port->send_bit(direction);
     }
 
-    result = LOG_NO_PRESENCE_ERROR;
-    return LOG_CONVERSION_RESULT;
+    search->last_discrepancy = last_zero;
+    search->is_last_device = (last_zero == 0U);
+
+    DEBUG_DUMP_HEX(DL_DEBUG, search->rom_code.raw, sizeof(search->rom_code.raw));
+    return true;
 }
 
 /*!
- * \brief 1Wire manager task function
+ * \brief Finds next rom space of supported family on the bus
+ *
+ * \details Search is started straight at the first supported family in
+ * search order and branches of unsupported families found on the way are
+ * skipped as a whole. Search ends once it passes the last supported
+ * family.
+ *
+ * \param search state of search algorithm, zeroed before first call
+ *
+ * \retval true next rom space found and stored in search state
+ * \retval false no more devices, last device flag is set, or no device
+ * responded
+ */
+static bool search_next_family(WIRE_search_t *search)
+{
+    /* https://www.maximintegrated.com/en/app-notes/index.mvp/id/187 */
+    uint8_t first_order = UINT8_MAX;
+    uint8_t last_order = 0U;
+    uint8_t first_family_code = 0U;
+    WIRE_family_t family;
+
+    for(uint8_t i = 0U; i < sizeof(families)/sizeof(families[0]); i++)
+    {
+        const uint8_t family_code = pgm_read_byte(&families[i].family_code);
+        const uint8_t order = get_family_order(family_code);
+
+        if(order < first_order)
+        {
+            first_order = order;
+            first_family_code = family_code;
+        }
+
+        last_order = (order > last_order) ? order : last_order;
+    }
+
+    if(!search->is_started)
+    {
+        /* target setup, rom bits follow family code of the first family */
+        memset(search, 0, sizeof(*search));
+        search->rom_code.family_code = first_family_code;
+        search->last_discrepancy = ROM_CODE_BITS;
+        search->is_started = true;
+    }
+
+    while(search_next(search, SEARCH_ROM))
+    {
+        const uint8_t family_code = search->rom_code.family_code;
+
+        if(get_family_order(family_code) > last_order)
+        {
+            search->is_last_device = true;
+            return false;
+        }
+
+        if(get_family(family_code, &family))
+        {
+            return true;
+        }
+
+        /* family skip setup */
+        DEBUG(DL_DEBUG, "Family 0x%02x skipped\n", family_code);
+        search->last_discrepancy = search->last_family_discrepancy;
+        search->last_family_discrepancy = 0U;
+
+        if(search->last_discrepancy == 0U)
+        {
+            search->is_last_device = true;
+        }
+    }
+
+    return false;
+}
+
+/*!
+ * \brief Moves to next valid sensor in round robin order
+ *
+ * \retval true next valid sensor selected
+ * \retval false there is no valid sensor on the bus
+ */
+static bool next_valid_device(void)
+{
+    for(uint8_t i = 0U; i < bus->devices_count; i++)
+    {
+        bus->current = (uint8_t)((bus->current + 1U) % bus->devices_count);
+
+        if(bus->devices[bus->current].is_valid)
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/*!
+ * \brief Checks whatever any valid sensor on the bus is parasite powered
+ *
+ * \retval true at least one sensor is parasite powered
+ * \retval false all sensors are externally powered
+ */
+static bool is_any_parasite_device(void)
+{
+    for(uint8_t i = 0U; i < bus->devices_count; i++)
+    {
+        if(bus->devices[i].is_valid && bus->devices[i].is_parasite)
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/*!
+ * \brief Moves to next valid sensor, which has not been configured yet
+ *
+ * \param from index of sensor to start looking from
+ *
+ * \retval true sensor to be configured selected
+ * \retval false all valid sensors are configured
+ */
+static bool next_unconfigured_device(uint8_t from)
+{
+    for(uint8_t i = from; i < bus->devices_count; i++)
+    {
+        if(bus->devices[i].is_valid && !bus->devices[i].is_configured)
+        {
+            bus->current = i;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/*!
+ * \brief Gets state after identification of handled sensor
+ *
+ * \returns next state
+ */
+static WIRE_state_t get_next_identification_state(void)
+{
+    bus->ident_retries = 0U;
+    bus->write_retries = 0U;
+
+    if(next_unconfigured_device(bus->current + 1U))
+    {
+        return WIRE_READ_ROM;
+    }
+
+    bus->is_warm_boot = false;
+    bus->is_parasite_bus = is_any_parasite_device();
+    DEBUG(DL_INFO, "Power mode %s\n", bus->is_parasite_bus ? "parasite" : "external");
+
+    return next_valid_device() ? START_CONVERSION : WIRE_ERROR_STATE;
+}
+
+/*!
+ * \brief Gets interval of polling for conversion completion
+ *
+ * \details Read slots would pull bus low and starve parasite powered
+ * sensors during conversion, so polling is used only if all sensors are
+ * externally powered.
+ *
+ * \returns polling interval, 0 if polling is disabled
+ */
+static uint8_t get_poll_interval(void)
+{
+    if(bus->is_parasite_bus)
+    {
+        return 0U;
+    }
+
+    return config.poll_interval;
+}
+
+/*!
+ * \brief Prepares transaction reading scratchpad space of sensor
+ *
+ * \param size number of bytes to be read, if less than size of scratchpad
+ * space transfer is aborted with reset
+ */
+static void prepare_read_scratchpad(uint8_t size)
+{
+    const uint8_t scratchpad_size =
+        sizeof(bus->scratchpad.raw)/sizeof(bus->scratchpad.raw[0]);
+
+    add_select();
+    add_tx_byte(READ_SCRATCHPAD);
+    set_rx_buffer(bus->scratchpad.raw, size);
+    bus->transaction.is_abort = (size < scratchpad_size);
+}
+
+/*!
+ * \brief Resets state of sensor before its identification
+ *
+ * \param dev sensor
+ */
+static void reset_device(WIRE_device_t *dev)
+{
+    dev->is_valid = true;
+    dev->is_ready = false;
+    dev->is_configured = false;
+    dev->is_written = false;
+    dev->resolution = get_family_resolution(dev);
+    dev->stable_count = 0U;
+    dev->is_alarming = false;
+    dev->is_filtered = false;
+    dev->window_count = 0U;
+    dev->window_pos = 0U;
+    dev->por_count = 0U;
+    dev->is_excluded = false;
+#if WIRE_MGR_STATS_ENABLED
+    dev->bus_time = 0U;
+#endif
+}
+
+/*!
+ * \brief Starts new entry of device table
+ *
+ * \details User settings and statistics of previous sensor don't apply.
+ *
+ * \param dev sensor
+ * \param rom_code rom space of sensor
+ */
+static void add_device(WIRE_device_t *dev, const WIRE_rom_code_space_t *rom_code)
+{
+    dev->rom_code = *rom_code;
+    dev->is_alarm_set = false;
+#if WIRE_MGR_STATS_ENABLED
+    memset(&dev->stats, 0, sizeof(dev->stats));
+#endif
+}
+
+/*!
+ * \brief Restarts background search
+ */
+static void restart_discovery(void)
+{
+    memset(&bus->discovery, 0, sizeof(bus->discovery));
+    bus->found_count = 0U;
+}
+
+#if WIRE_MGR_ROM_CACHE_ENABLED
+/*!
+ * \brief Calculates crc of sensors table stored in EEPROM
+ *
+ * \param cache table of sensors
+ *
+ * \returns crc of version, count and stored rom spaces
+ */
+static uint8_t calc_rom_cache_crc(const WIRE_rom_cache_t *cache)
+{
+    uint8_t crc = calc_crc_block(0U, &cache->version, sizeof(cache->version));
+
+    crc = calc_crc_block(crc, &cache->count, sizeof(cache->count));
+    return calc_crc_block(crc, cache->rom_codes[0].raw,
+            cache->count * sizeof(cache->rom_codes[0]));
+}
+
+/*!
+ * \brief Stores table of sensors of handled bus in EEPROM
+ *
+ * \note Only changed bytes are written, so the same table found on every
+ * search does not wear EEPROM
+ */
+static void store_rom_table(void)
+{
+    WIRE_rom_cache_t cache;
+    WIRE_rom_cache_t *stored = &rom_cache[bus - buses];
+
+    cache.version = ROM_CACHE_VERSION;
+    cache.count = bus->devices_count;
+
+    for(uint8_t i = 0U; i < bus->devices_count; i++)
+    {
+        cache.rom_codes[i] = bus->devices[i].rom_code;
+    }
+
+    cache.crc = calc_rom_cache_crc(&cache);
+    eeprom_update_block(cache.rom_codes, stored->rom_codes,
+            cache.count * sizeof(cache.rom_codes[0]));
+    /* header last, so interrupted write leaves invalid crc */
+    eeprom_update_block(&cache, stored, offsetof(WIRE_rom_cache_t, rom_codes));
+}
+
+/*!
+ * \brief Loads table of sensors of handled bus from EEPROM
+ *
+ * \retval true valid table loaded
+ * \retval false there is no valid table, bus has to be searched
+ */
+static bool load_rom_table(void)
+{
+    WIRE_rom_cache_t cache;
+    const WIRE_rom_cache_t *stored = &rom_cache[bus - buses];
+
+    eeprom_read_block(&cache, stored, offsetof(WIRE_rom_cache_t, rom_codes));
+
+    if((cache.version != ROM_CACHE_VERSION) || (cache.count == 0U) ||
+            (cache.count > WIRE_MGR_MAX_DEVICES))
+    {
+        return false;
+    }
+
+    eeprom_read_block(cache.rom_codes, stored->rom_codes,
+            cache.count * sizeof(cache.rom_codes[0]));
+
+    if(calc_rom_cache_crc(&cache) != cache.crc)
+    {
+        DEBUG(DL_WARNING, "%s\n", "Stored sensors table corrupted");
+        return false;
+    }
+
+    for(uint8_t i = 0U; i < cache.count; i++)
+    {
+        bus->devices[i].rom_code = cache.rom_codes[i];
+        reset_device(&bus->devices[i]);
+    }
+
+    bus->devices_count = cache.count;
+    DEBUG(DL_INFO, "Loaded %d sensor(s)\n", bus->devices_count);
+    return true;
+}
+#endif
+
+/*!
+ * \brief Handles \ref WIRE_SEARCH_ROM state
+ *
+ * \details Search yields between found rom spaces once bus budget of task
+ * call is used up and resumes on the next call
+ *
+ * \returns next state
+ */
+static WIRE_state_t handle_search_rom(void)
+{
+    const bool is_crc = CONFIG_IS_CRC;
+    WIRE_search_t *search = &bus->search;
+
+    if(!bus->is_search_pending)
+    {
+        memset(search, 0, sizeof(*search));
+        bus->devices_count = 0U;
+        bus->current = 0U;
+        bus->ident_retries = 0U;
+        bus->write_retries = 0U;
+        restart_discovery();
+    }
+
+    bus->is_search_pending = false;
+
+    while(bus->devices_count < WIRE_MGR_MAX_DEVICES)
+    {
+        WIRE_device_t *dev = &bus->devices[bus->devices_count];
+
+        if(!take_search_budget())
+        {
+            bus->is_search_pending = true;
+            return WIRE_SEARCH_ROM;
+        }
+
+        if(!search_next_family(search))
+        {
+            break;
+        }
+
+        if(is_crc && !is_crc_valid(search->rom_code.raw, sizeof(search->rom_code.raw) - 1U,
+                    search->rom_code.crc))
+        {
+            bus->devices_count = 0U;
+            bus->result = LOG_CRC_ERROR;
+            return LOG_CONVERSION_RESULT;
+        }
+
+        if(memcmp(dev->rom_code.raw, search->rom_code.raw, sizeof(dev->rom_code.raw)) != 0)
+        {
+            add_device(dev, &search->rom_code);
+        }
+
+        reset_device(dev);
+        bus->devices_count++;
+    }
+
+    /* devices differing in any bit are seen already by the first pass */
+    bus->is_single_device = (bus->devices_count == 1U) && !search->is_discrepancy;
+    DEBUG(DL_INFO, "Found %d sensor(s)\n", bus->devices_count);
+
+    if(bus->devices_count == 0U)
+    {
+        bus->result = LOG_NO_PRESENCE_ERROR;
+        return LOG_CONVERSION_RESULT;
+    }
+
+#if WIRE_MGR_ROM_CACHE_ENABLED
+    store_rom_table();
+#endif
+
+    return WIRE_READ_ROM;
+}
+
+/*!
+ * \brief Handles \ref WIRE_READ_ROM state
+ *
+ * \returns next state
+ */
+static WIRE_state_t handle_read_rom(void)
+{
+    const WIRE_rom_code_space_t *rom_code = &bus->devices[bus->current].rom_code;
+    WIRE_family_t family;
+
+    /* parasite powered sensors pull bus low on read slot */
+    bus->devices[bus->current].is_parasite = ((bus->power_supply & 0x01U) == 0U);
+
+    if(!get_family(rom_code->family_code, &family) ||
+            (rom_code->serial_no[4] != 0U) ||
+            (rom_code->serial_no[5] != 0U))
+    {
+        const bool is_fake_allowed  = CONFIG_IS_FAKE_ALLOWED;
+
+        DEBUG(is_fake_allowed ? DL_WARNING: DL_ERROR, "%s\n", "Invalid ROM code");
+
+        if(!is_fake_allowed)
+        {
+            bus->result = LOG_FAKE_SENSOR_ERROR;
+            return LOG_CONVERSION_RESULT;
+        }
+    }
+
+    return WIRE_READ_SCRATCHPAD;
+}
+
+/*!
+ * \brief Checks configuration read from scratchpad space of handled sensor
+ *
+ * \details Sensor recalls configuration from its EEPROM on power up, so if
+ * it has been made persistent, write is skipped. Written configuration is
+ * read back and then optionally copied to EEPROM, which happens only once
+ * for the sensor as recalled configuration matches afterwards.
+ *
+ * \returns next state
+ */
+static WIRE_state_t check_configuration(void)
+{
+    WIRE_device_t *dev = &bus->devices[bus->current];
+    const bool is_written = dev->is_written;
+
+    dev->is_written = false;
+
+    if((is_configurable(dev) && (bus->scratchpad.config != get_device_mask(dev))) ||
+            (bus->scratchpad.th != (uint8_t)dev->th) ||
+            (bus->scratchpad.tl != (uint8_t)dev->tl))
+    {
+        if(is_written)
+        {
+            DEBUG(DL_WARNING, "Config 0x%02x not written\n", bus->scratchpad.config);
+            bus->result = LOG_CONFIG_ERROR;
+            return LOG_CONVERSION_RESULT;
+        }
+
+        return WIRE_WRITE_SCRATCHPAD;
+    }
+
+    if(is_written && config.is_persistent)
+    {
+        return WIRE_COPY_SCRATCHPAD;
+    }
+
+    dev->is_configured = true;
+    return get_next_identification_state();
+}
+
+/*!
+ * \brief Handles \ref WIRE_READ_SCRATCHPAD state
+ *
+ * \returns next state
+ */
+static WIRE_state_t handle_read_scratchpad(void)
+{
+    const bool is_crc = is_crc_checked();
+
+    if(is_crc && !is_block_crc_valid(bus->rx_crc))
+    {
+        bus->result = LOG_CRC_ERROR;
+        return LOG_CONVERSION_RESULT;
+    }
+
+    if(!is_reserved_values_valid(bus->scratchpad.reserved1, bus->scratchpad.reserved3))
+    {
+        const bool is_fake_allowed  = CONFIG_IS_FAKE_ALLOWED;
+
+        DEBUG(is_fake_allowed ? DL_WARNING: DL_ERROR, "%s\n", "Invalid reserved bytes");
+
+        if(!is_fake_allowed)
+        {
+            bus->result = LOG_FAKE_SENSOR_ERROR;
+            return LOG_CONVERSION_RESULT;
+        }
+    }
+
+    bus->devices[bus->current].temperature = decode_temperature();
+
+    if(!bus->devices[bus->current].is_alarm_set)
+    {
+        bus->devices[bus->current].th = (int8_t)bus->scratchpad.th;
+        bus->devices[bus->current].tl = (int8_t)bus->scratchpad.tl;
+    }
+
+    return check_configuration();
+}
+
+/*!
+ * \brief Handles \ref WIRE_WRITE_SCRATCHPAD state
+ *
+ * \returns next state
+ */
+static WIRE_state_t handle_write_scratchpad(void)
+{
+    /* written configuration is checked by reading it back */
+    bus->devices[bus->current].is_written = true;
+    return WIRE_READ_SCRATCHPAD;
+}
+
+/*!
+ * \brief Handles \ref WIRE_COPY_SCRATCHPAD state
+ *
+ * \returns next state
+ */
+static WIRE_state_t handle_copy_scratchpad(void)
+{
+    bus->start_copy_time = SYSTEM_timer_get_tick();
+    return WAIT_FOR_COPY;
+}
+
+/*!
+ * \brief Handles \ref WAIT_FOR_COPY state
+ *
+ * \details Parasite powered sensor is supplied by strong pullup till
+ * copying is done
+ *
+ * \returns next state
+ */
+static WIRE_state_t handle_wait_for_copy(void)
+{
+    if(SYSTEM_timer_tick_difference(bus->start_copy_time,
+                SYSTEM_timer_get_tick()) <= COPY_SCRATCHPAD_TIME)
+    {
+        return WAIT_FOR_COPY;
+    }
+
+    if(bus->devices[bus->current].is_parasite)
+    {
+        bus->port->set_strong_pullup(false);
+    }
+
+    bus->devices[bus->current].is_configured = true;
+    return get_next_identification_state();
+}
+
+/*!
+ * \brief Checks whatever sensors are converted with broadcast
+ *
+ * \retval true conversions are started with single broadcast
+ * \retval false sensors are converted one by one
+ */
+static bool is_sweep_mode(void)
+{
+    return config.is_sweep ||
+        config.is_alarm_sweep;
+}
+
+/*!
+ * \brief Gets state reading results once conversion is done
+ *
+ * \returns \ref WIRE_ALARM_SEARCH in alarm sweep mode, \ref
+ * READ_CONVERSION_RESULT otherwise
+ */
+static WIRE_state_t get_readout_state(void)
+{
+    if(config.is_alarm_sweep)
+    {
+        return WIRE_ALARM_SEARCH;
+    }
+
+    return READ_CONVERSION_RESULT;
+}
+
+/*!
+ * \brief Gets time of started conversion
+ *
+ * \details In sweep mode all sensors convert at once, so the slowest of them
+ * sets the time
+ *
+ * \returns conversion time
+ */
+static uint16_t get_conversion_time(void)
+{
+    uint16_t ret;
+
+    if(!is_sweep_mode())
+    {
+        return get_device_conv_time(&bus->devices[bus->current]);
+    }
+
+    ret = CONVERSION_TIME_9BIT;
+
+    for(uint8_t i = 0U; i < bus->devices_count; i++)
+    {
+        if(bus->devices[i].is_valid)
+        {
+            const uint16_t time = get_device_conv_time(&bus->devices[i]);
+
+            ret = (time > ret) ? time : ret;
+        }
+    }
+
+    return ret;
+}
+
+/*!
+ * \brief Checks whatever conversion of handled sensor starts sampling round
+ *
+ * \retval true conversion starts sampling round
+ * \retval false conversion continues sampling round
+ */
+static bool is_round_start(void)
+{
+    if(is_sweep_mode())
+    {
+        return true;
+    }
+
+    for(uint8_t i = 0U; i < bus->current; i++)
+    {
+        if(bus->devices[i].is_valid)
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/*!
+ * \brief Gets time left till start of next sampling round
+ *
+ * \returns delay in ticks, 0 if conversion can be started
+ */
+static uint16_t get_sample_delay(void)
+{
+    const uint16_t interval = config.sample_interval;
+    uint32_t elapsed;
+
+    if((interval == 0U) || !bus->is_round_started || !is_round_start())
+    {
+        return 0U;
+    }
+
+    elapsed = SYSTEM_timer_tick_difference(bus->start_round_time, SYSTEM_timer_get_tick());
+    return (elapsed >= interval) ? 0U : (uint16_t)(interval - elapsed);
+}
+
+/*!
+ * \brief Handles \ref START_CONVERSION state
+ *
+ * \returns next state
+ */
+static WIRE_state_t handle_start_conversion(void)
+{
+    bus->conversion_time = get_conversion_time();
+    bus->start_conv_time = SYSTEM_timer_get_tick();
+
+    if(is_round_start())
+    {
+        bus->start_round_time = bus->start_conv_time;
+        bus->is_round_started = true;
+    }
+
+    return WAIT_FOR_CONVERTION;
+}
+
+/*!
+ * \brief Handles \ref WAIT_FOR_CONVERTION state
+ *
+ * \details If polling is enabled, read slot is issued. Externally powered
+ * sensor answers with 1 once conversion is done, sensors converting in
+ * sweep keep bus low till the last of them is done. Conversion time of
+ * resolution is kept as a ceiling.
+ *
+ * \returns next state
+ */
+static WIRE_state_t handle_wait_for_conversion(void)
+{
+    const uint8_t poll_interval = get_poll_interval();
+
+    if(SYSTEM_timer_tick_difference(bus->start_conv_time,
+                SYSTEM_timer_get_tick()) > bus->conversion_time)
+    {
+        if(bus->is_parasite_bus)
+        {
+            bus->port->set_strong_pullup(false);
+        }
+
+        return get_readout_state();
+    }
+
+    if((poll_interval != 0U) && bus->port->read_bit())
+    {
+        DEBUG(DL_DEBUG, "Conversion done after %d\n",
+                (int)SYSTEM_timer_tick_difference(bus->start_conv_time, SYSTEM_timer_get_tick()));
+        return get_readout_state();
+    }
+
+    return WAIT_FOR_CONVERTION;
+}
+
+/*!
+ * \brief Gets index of handled sensor in public API
+ *
+ * \returns index of sensor across buses
+ */
+static uint8_t get_device_index(void)
+{
+    uint8_t ret = bus->current;
+
+    for(const WIRE_bus_t *b = buses; b != bus; b++)
+    {
+        ret += b->devices_count;
+    }
+
+    return ret;
+}
+
+/*!
+ * \brief Stores result of last operation on handled sensor in history
+ */
+static void store_sample(void)
+{
+    WIRE_MGR_sample_t *sample = &samples[samples_seq % WIRE_MGR_SAMPLES_SIZE];
+
+    sample->tick = SYSTEM_timer_get_tick();
+    sample->seq = samples_seq;
+    sample->idx = get_device_index();
+    sample->status = bus->result;
+    sample->raw = bus->devices[bus->current].temperature;
+    samples_seq++;
+}
+
+#if WIRE_MGR_STATS_ENABLED
+/*!
+ * \brief Updates minimal and maximal value of statistics
+ *
+ * \param min minimal value
+ * \param max maximal value
+ * \param value new value
+ * \param is_first value is the first one
+ */
+static void update_min_max(uint16_t *min, uint16_t *max, uint16_t value, bool is_first)
+{
+    if(is_first || (value < *min))
+    {
+        *min = value;
+    }
+
+    if(is_first || (value > *max))
+    {
+        *max = value;
+    }
+}
+
+/*!
+ * \brief Updates statistics of handled sensor with last result
+ */
+static void update_stats(void)
+{
+    WIRE_device_t *dev = &bus->devices[bus->current];
+    WIRE_stats_t *stats = &dev->stats;
+    uint32_t total = 0U;
+
+    stats->count[bus->result]++;
+
+    for(uint8_t i = 0U; i < LOG_SENTINEL; i++)
+    {
+        total += stats->count[i];
+    }
+
+    update_min_max(&stats->bus_time_min, &stats->bus_time_max, dev->bus_time, total == 1U);
+    stats->bus_time_sum += dev->bus_time;
+    dev->bus_time = 0U;
+
+    if(bus->result == LOG_SUCCESS)
+    {
+        const uint16_t latency = (uint16_t)SYSTEM_timer_tick_difference(bus->start_conv_time,
+                SYSTEM_timer_get_tick());
+
+        update_min_max(&stats->latency_min, &stats->latency_max, latency,
+                stats->count[LOG_SUCCESS] == 1U);
+        stats->latency_sum += latency;
+    }
+}
+#endif
+
+/*!
+ * \brief Logs result of last operation on handled sensor
+ */
+static void log_result(void)
+{
+    const int16_t temperature = bus->devices[bus->current].temperature;
+#if WIRE_MGR_STATS_ENABLED
+    const uint32_t *count = bus->devices[bus->current].stats.count;
+
+    update_stats();
+#endif
+
+    switch(bus->result)
+    {
+        case LOG_SUCCESS:
+            DEBUG(DL_INFO, "1WIRE[%d]: 0x%04x[raw] %d.%04d[C]\n", bus->current, temperature,
+                    temperature >> 4U, (temperature & 0xFu)*625u);
+
+            if(sample_cb != NULL)
+            {
+                sample_cb(get_device_index(), temperature);
+            }
+            break;
+        case LOG_CRC_ERROR:
+            DEBUG(DL_WARNING, "%s", "CRC error\n");
+            break;
+        case LOG_NO_PRESENCE_ERROR:
+            DEBUG(DL_WARNING, "%s", "No Presence\n");
+            break;
+        case LOG_FAKE_SENSOR_ERROR:
+            DEBUG(DL_ERROR, "%s", "Fake sensor\n");
+            break;
+        case LOG_CONFIG_ERROR:
+            DEBUG(DL_WARNING, "%s", "Config error\n");
+            break;
+        default:
+            ASSERT(false);
+    }
+
+#if WIRE_MGR_STATS_ENABLED
+    DEBUG(DL_INFO, "OK[%lu] CRC[%lu] PRE[%lu] FAKE[%lu] CFG[%lu]\n",
+            count[LOG_SUCCESS], count[LOG_CRC_ERROR],
+            count[LOG_NO_PRESENCE_ERROR], count[LOG_FAKE_SENSOR_ERROR],
+            count[LOG_CONFIG_ERROR]);
+#endif
+#if WIRE_MGR_BENCH_ENABLED
+    bench_is_sampled = true;
+#endif
+
+    store_sample();
+}
+
+/*!
+ * \brief Checks whatever conversion result is read without the rest of
+ * scratchpad space
+ *
+ * \details Sensor converting with fixed resolution needs count remain
+ * register, so its scratchpad space is read whole
+ *
+ * \retval true only temperature bytes are read
+ * \retval false whole scratchpad space is read
+ */
+static bool is_fast_read(void)
+{
+    const bool is_crc = CONFIG_IS_CRC;
+
+    return !is_crc && config.is_fast_read && is_configurable(&bus->devices[bus->current]);
+}
+
+/*!
+ * \brief Adapts resolution of handled sensor to rate of temperature change
+ *
+ * \details Fast changing sensor drops to 9 bit resolution for short
+ * conversions, after \ref ADAPTIVE_STABLE_COUNT stable samples configured
+ * resolution is restored. Sensor is reconfigured only if resolution
+ * changes.
+ *
+ * \param temperature newly read temperature
+ */
+static void adapt_resolution(int16_t temperature)
+{
+    const uint8_t max_resolution = CONFIG_RESOLUTION;
+    WIRE_device_t *dev = &bus->devices[bus->current];
+    const int16_t diff = temperature - dev->temperature;
+    const uint16_t delta = (uint16_t)((diff < 0) ? -diff : diff);
+    const int16_t quantum = get_resolution_quantum(dev->resolution);
+    const uint16_t stable_delta =
+        ((uint16_t)quantum > ADAPTIVE_STABLE_DELTA) ? (uint16_t)quantum : ADAPTIVE_STABLE_DELTA;
+    uint8_t new_resolution = dev->resolution;
+
+    if(delta >= ADAPTIVE_FAST_DELTA)
+    {
+        dev->stable_count = 0U;
+        new_resolution = WIRE_9BIT_RESOLUTION;
+    }
+    else if(delta <= stable_delta)
+    {
+        if(dev->stable_count < ADAPTIVE_STABLE_COUNT)
+        {
+            dev->stable_count++;
+        }
+
+        if(dev->stable_count == ADAPTIVE_STABLE_COUNT)
+        {
+            new_resolution = max_resolution;
+        }
+    }
+    else
+    {
+        dev->stable_count = 0U;
+    }
+
+    if(new_resolution != dev->resolution)
+    {
+        DEBUG(DL_INFO, "1WIRE[%d]: resolution %d -> %d\n", bus->current,
+                dev->resolution, new_resolution);
+        dev->resolution = new_resolution;
+        dev->is_configured = false;
+    }
+}
+
+/*!
+ * \brief Gets filtered temperature of sensor in raw temperature units
+ *
+ * \param dev sensor
+ *
+ * \returns filtered temperature
+ */
+static int16_t get_filtered_value(const WIRE_device_t *dev)
+{
+    if(config.filter == WIRE_MGR_FILTER_EMA)
+    {
+        /* rounded to nearest */
+        return (int16_t)((dev->filtered + (1 << (EMA_FRACTION_BITS - 1U))) >> EMA_FRACTION_BITS);
+    }
+
+    return dev->filtered;
+}
+
+/*!
+ * \brief Checks whatever reading is power on reset value to be rejected
+ *
+ * \details Sensor, which lost power, reports POR value till it converts
+ * again. POR value is accepted if filtered value is close to it or it is
+ * read \ref POR_ACCEPT_COUNT times in a row, as real 85 [C] would be.
+ *
+ * \param dev sensor
+ * \param temperature reading
+ *
+ * \retval true reading is rejected
+ * \retval false reading is accepted
+ */
+static bool is_por_spike(WIRE_device_t *dev, int16_t temperature)
+{
+    if(temperature != POR_TEMPERATURE)
+    {
+        dev->por_count = 0U;
+        return false;
+    }
+
+    if(dev->is_filtered)
+    {
+        int16_t diff = get_filtered_value(dev) - POR_TEMPERATURE;
+
+        if((diff < POR_ACCEPT_DELTA) && (diff > -POR_ACCEPT_DELTA))
+        {
+            return false;
+        }
+    }
+
+    if(dev->por_count < POR_ACCEPT_COUNT)
+    {
+        dev->por_count++;
+    }
+
+    return (dev->por_count < POR_ACCEPT_COUNT);
+}
+
+/*!
+ * \brief Gets median of readings in window of median filter
+ *
+ * \param dev sensor
+ *
+ * \returns median of readings
+ */
+static int16_t get_window_median(const WIRE_device_t *dev)
+{
+    int16_t sorted[WIRE_MGR_MEDIAN_SIZE];
+
+    for(uint8_t i = 0U; i < dev->window_count; i++)
+    {
+        uint8_t j = i;
+
+        /* insertion sort, window is small */
+        while((j > 0U) && (sorted[j - 1U] > dev->window[i]))
+        {
+            sorted[j] = sorted[j - 1U];
+            j--;
+        }
+
+        sorted[j] = dev->window[i];
+    }
+
+    return sorted[dev->window_count / 2U];
+}
+
+/*!
+ * \brief Feeds reading of handled sensor to filter
+ *
+ * \param temperature reading
+ */
+static void filter_temperature(int16_t temperature)
+{
+    WIRE_device_t *dev = &bus->devices[bus->current];
+
+    if(is_por_spike(dev, temperature))
+    {
+        DEBUG(DL_WARNING, "1WIRE[%d]: POR value rejected\n", bus->current);
+        return;
+    }
+
+    switch(config.filter)
+    {
+        case WIRE_MGR_FILTER_EMA:
+        {
+            const int16_t value = (int16_t)(temperature * (1 << EMA_FRACTION_BITS));
+
+            if(!dev->is_filtered)
+            {
+                dev->filtered = value;
+            }
+            else
+            {
+                dev->filtered += (int16_t)((value - dev->filtered) >> WIRE_MGR_EMA_SHIFT);
+            }
+            break;
+        }
+        case WIRE_MGR_FILTER_MEDIAN:
+            dev->window[dev->window_pos] = temperature;
+            dev->window_pos = (uint8_t)((dev->window_pos + 1U) % WIRE_MGR_MEDIAN_SIZE);
+
+            if(dev->window_count < WIRE_MGR_MEDIAN_SIZE)
+            {
+                dev->window_count++;
+            }
+
+            dev->filtered = get_window_median(dev);
+            break;
+        case WIRE_MGR_FILTER_NONE:
+        default:
+            dev->filtered = temperature;
+            break;
+    }
+
+    dev->is_filtered = true;
+}
+
+/*!
+ * \brief Checks conversion result read from handled sensor
+ *
+ * \returns result of operation as log code
+ */
+static uint8_t check_conversion_result(void)
+{
+    const bool is_crc = CONFIG_IS_CRC;
+    const bool is_fast = is_fast_read();
+    const uint8_t resolution = bus->devices[bus->current].resolution;
+    int16_t temperature;
+
+    if(is_crc && !is_block_crc_valid(bus->rx_crc))
+    {
+        return LOG_CRC_ERROR;
+    }
+
+    if(!is_fast && is_configurable(&bus->devices[bus->current]) &&
+            (bus->scratchpad.config != get_device_mask(&bus->devices[bus->current])))
+    {
+        /* sensor lost its configuration e.g. due to power glitch */
+        DEBUG(DL_WARNING, "Config 0x%02x lost\n", bus->scratchpad.config);
+        bus->devices[bus->current].is_configured = false;
+    }
+
+    /* bits below resolution are undefined */
+    temperature = decode_temperature() &
+        (int16_t)~(get_resolution_quantum(resolution) - 1);
+
+    if(config.is_adaptive_resolution && bus->devices[bus->current].is_ready &&
+            is_configurable(&bus->devices[bus->current]))
+    {
+        adapt_resolution(temperature);
+    }
+
+    filter_temperature(temperature);
+    bus->devices[bus->current].temperature = temperature;
+    bus->devices[bus->current].is_ready = true;
+    return LOG_SUCCESS;
+}
+
+/*!
+ * \brief Finds next valid sensor of the sweep
+ *
+ * \returns index of next sensor, devices count if all sensors of the sweep
+ * have been handled
+ */
+static uint8_t get_next_sweep_device(void)
+{
+    const bool is_alarm_sweep = config.is_alarm_sweep;
+    uint8_t i;
+
+    for(i = bus->current + 1U; i < bus->devices_count; i++)
+    {
+        if(bus->devices[i].is_valid && (!is_alarm_sweep || bus->devices[i].is_alarming))
+        {
+            break;
+        }
+    }
+
+    return i;
+}
+
+/*!
+ * \brief Checks whatever conversion result is read again after error
+ *
+ * \details Conversion result stays in scratchpad space till next
+ * conversion, so transient bus error is retried straight away instead of
+ * converting again
+ *
+ * \retval true conversion result is read again
+ * \retval false result is final
+ */
+static bool is_read_retry(void)
+{
+    if(((bus->result != LOG_CRC_ERROR) && (bus->result != LOG_NO_PRESENCE_ERROR)) ||
+            (bus->retries >= config.read_retries))
+    {
+        bus->retries = 0U;
+        return false;
+    }
+
+    DEBUG(DL_DEBUG, "1WIRE[%d]: retry %d\n", bus->current, bus->retries);
+    bus->retries++;
+#if WIRE_MGR_STATS_ENABLED
+    bus->devices[bus->current].stats.retries++;
+#endif
+    return true;
+}
+
+/*!
+ * \brief Handles \ref READ_CONVERSION_RESULT state
+ *
+ * \returns next state
+ */
+static WIRE_state_t handle_read_conversion_results(void)
+{
+    BENCH_START();
+    bus->result = check_conversion_result();
+    BENCH_STOP(BENCH_DECODE);
+    return is_read_retry() ? READ_CONVERSION_RESULT : LOG_CONVERSION_RESULT;
+}
+
+/*!
+ * \brief Handles \ref READ_CONVERSION_RESULT state in sweep mode
+ *
+ * \details All sensors have been converted by single broadcast, so results of
+ * every sensor are collected one after another, in alarm sweep mode only
+ * results of alarming sensors. Result of the last sensor is left for \ref
+ * LOG_CONVERSION_RESULT state.
+ *
+ * \returns next state
+ */
+static WIRE_state_t handle_read_sweep_results(void)
+{
+    BENCH_START();
+    bus->result = check_conversion_result();
+    BENCH_STOP(BENCH_DECODE);
+
+    if(is_read_retry())
+    {
+        return READ_CONVERSION_RESULT;
+    }
+
+    const uint8_t next = get_next_sweep_device();
+
+    if(next < bus->devices_count)
+    {
+        /* result belongs to the sensor just read */
+        log_result();
+        bus->current = next;
+        return READ_CONVERSION_RESULT;
+    }
+
+    return LOG_CONVERSION_RESULT;
+}
+
+/*!
+ * \brief Excludes handled sensor from measurements
+ *
+ * \param is_retried sensor is identified again after \ref EXCLUDE_PERIOD
+ */
+static void exclude_device(bool is_retried)
+{
+    bus->devices[bus->current].is_valid = false;
+    bus->devices[bus->current].is_excluded = is_retried;
+    bus->exclude_time = SYSTEM_timer_get_tick();
+}
+
+/*!
+ * \brief Returns sensors excluded on failed identification back to
+ * identification once \ref EXCLUDE_PERIOD elapsed
+ *
+ * \retval true any sensor has been returned
+ * \retval false there is no sensor to be returned yet
+ */
+static bool restore_excluded_devices(void)
+{
+    bool is_restored = false;
+
+    if(SYSTEM_timer_tick_difference(bus->exclude_time, SYSTEM_timer_get_tick()) <= EXCLUDE_PERIOD)
+    {
+        return false;
+    }
+
+    for(uint8_t i = 0U; i < bus->devices_count; i++)
+    {
+        if(bus->devices[i].is_excluded)
+        {
+            reset_device(&bus->devices[i]);
+            is_restored = true;
+        }
+    }
+
+    return is_restored;
+}
+
+/*!
+ * \brief Gets state starting next sampling round
+ *
+ * \details Sensors excluded on failed identification are identified again
+ * after back-off. Sensors which lost configuration or got new settings are
+ * configured first, in hot plug mode background search step runs before
+ * conversion.
+ *
+ * \returns next state
+ */
+static WIRE_state_t get_next_round_state(void)
+{
+    if(restore_excluded_devices() && next_unconfigured_device(0U))
+    {
+        /* power mode may have failed to be read too */
+        return WIRE_READ_ROM;
+    }
+
+    if(next_unconfigured_device(0U))
+    {
+        /* rom space and power mode are known already */
+        return WIRE_READ_SCRATCHPAD;
+    }
+
+    if(!next_valid_device())
+    {
+        return WIRE_ERROR_STATE;
+    }
+
+    return config.is_hot_plug ? WIRE_DISCOVERY : START_CONVERSION;
+}
+
+/*!
+ * \brief Finds sensor of given rom space in device table
+ *
+ * \param rom_code rom space to be found
+ *
+ * \returns index of sensor, devices count if not found
+ */
+static uint8_t find_device(const WIRE_rom_code_space_t *rom_code)
+{
+    uint8_t i;
+
+    for(i = 0U; i < bus->devices_count; i++)
+    {
+        if(memcmp(bus->devices[i].rom_code.raw, rom_code->raw, sizeof(rom_code->raw)) == 0)
+        {
+            break;
+        }
+    }
+
+    return i;
+}
+
+/*!
+ * \brief Handles \ref WIRE_ALARM_SEARCH state
+ *
+ * \details ALARM_SEARCH walks only branches of sensors, which temperature
+ * is out of TH/TL bounds, so only those are read afterwards. Search
+ * yields between found rom spaces once bus budget of task call is used up
+ * and resumes on the next call.
+ *
+ * \returns next state
+ */
+static WIRE_state_t handle_alarm_search(void)
+{
+    const bool is_crc = CONFIG_IS_CRC;
+    WIRE_search_t *search = &bus->search;
+
+    if(!bus->is_search_pending)
+    {
+        memset(search, 0, sizeof(*search));
+
+        for(uint8_t i = 0U; i < bus->devices_count; i++)
+        {
+            bus->devices[i].is_alarming = false;
+        }
+    }
+
+    bus->is_search_pending = false;
+
+    for(;;)
+    {
+        uint8_t idx;
+
+        if(!take_search_budget())
+        {
+            bus->is_search_pending = true;
+            return WIRE_ALARM_SEARCH;
+        }
+
+        if(!search_next(search, ALARM_SEARCH))
+        {
+            break;
+        }
+
+        if(is_crc && !is_crc_valid(search->rom_code.raw, sizeof(search->rom_code.raw) - 1U,
+                    search->rom_code.crc))
+        {
+            bus->result = LOG_CRC_ERROR;
+            return LOG_CONVERSION_RESULT;
+        }
+
+        idx = find_device(&search->rom_code);
+
+        if(idx < bus->devices_count)
+        {
+            bus->devices[idx].is_alarming = true;
+        }
+    }
+
+    for(uint8_t i = 0U; i < bus->devices_count; i++)
+    {
+        if(bus->devices[i].is_valid && bus->devices[i].is_alarming)
+        {
+            bus->current = i;
+            return READ_CONVERSION_RESULT;
+        }
+    }
+
+    /* quiet bus, round ends without logging */
+    return get_next_round_state();
+}
+
+/*!
+ * \brief Checks whatever rom space has been found by background search
+ *
+ * \param rom_code rom space to be checked
+ * \param is_used flags of found rom spaces, flag of matching one is set
+ *
+ * \retval true rom space found
+ * \retval false rom space not found
+ */
+static bool is_discovered(const WIRE_rom_code_space_t *rom_code, bool *is_used)
+{
+    for(uint8_t i = 0U; i < bus->found_count; i++)
+    {
+        if(memcmp(bus->found[i].raw, rom_code->raw, sizeof(rom_code->raw)) == 0)
+        {
+            is_used[i] = true;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/*!
+ * \brief Updates device table with result of finished background search
+ *
+ * \details Table is updated in single call, so task readers never see it
+ * half done. Sensors still present keep their state, missing sensors are
+ * dropped and added ones are identified like after \ref WIRE_SEARCH_ROM.
+ *
+ * \returns next state
+ */
+static WIRE_state_t update_devices(void)
+{
+    bool is_used[WIRE_MGR_MAX_DEVICES] = {false};
+    bool is_changed = false;
+    uint8_t count = 0U;
+
+    for(uint8_t i = 0U; i < bus->devices_count; i++)
+    {
+        if(!is_discovered(&bus->devices[i].rom_code, is_used))
+        {
+            DEBUG(DL_INFO, "1WIRE[%d]: removed\n", i);
+            is_changed = true;
+            continue;
+        }
+
+        if(count != i)
+        {
+            bus->devices[count] = bus->devices[i];
+        }
+
+        count++;
+    }
+
+    for(uint8_t i = 0U; (i < bus->found_count) && (count < WIRE_MGR_MAX_DEVICES); i++)
+    {
+        if(!is_used[i])
+        {
+            WIRE_device_t *dev = &bus->devices[count];
+
+            DEBUG(DL_INFO, "1WIRE[%d]: added\n", count);
+            add_device(dev, &bus->found[i]);
+            reset_device(dev);
+            is_changed = true;
+            count++;
+        }
+    }
+
+    bus->is_single_device = (count == 1U) && !bus->discovery.is_discrepancy;
+    restart_discovery();
+
+    if(!is_changed)
+    {
+        return START_CONVERSION;
+    }
+
+    bus->devices_count = count;
+
+    if(count == 0U)
+    {
+        /* all sensors gone, full search reports missing presence */
+        bus->current = 0U;
+        return WIRE_SEARCH_ROM;
+    }
+
+#if WIRE_MGR_ROM_CACHE_ENABLED
+    store_rom_table();
+#endif
+
+    if(next_unconfigured_device(0U))
+    {
+        return WIRE_READ_ROM;
+    }
+
+    bus->current = (uint8_t)(count - 1U);
+    return next_valid_device() ? START_CONVERSION : WIRE_ERROR_STATE;
+}
+
+/*!
+ * \brief Handles \ref WIRE_DISCOVERY state
+ *
+ * \details Single rom space is searched on each call, between conversions,
+ * search resumes from the last discrepancy on the next call. Device table
+ * is updated once whole bus has been searched. If bus budget of task call
+ * is used up, search pass waits for the next call.
+ *
+ * \returns next state
+ */
+static WIRE_state_t handle_discovery(void)
+{
+    WIRE_search_t *search = &bus->discovery;
+
+    bus->is_search_pending = !take_search_budget();
+
+    if(bus->is_search_pending)
+    {
+        return WIRE_DISCOVERY;
+    }
+
+    if(!search_next_family(search))
+    {
+        if(search->is_last_device)
+        {
+            /* no more supported sensors */
+            return update_devices();
+        }
+
+        /* pass is not reliable, errors are left for normal readout */
+        restart_discovery();
+        return START_CONVERSION;
+    }
+
+    if(CONFIG_IS_CRC && !is_crc_valid(search->rom_code.raw, sizeof(search->rom_code.raw) - 1U,
+                search->rom_code.crc))
+    {
+        restart_discovery();
+        return START_CONVERSION;
+    }
+
+    bus->found[bus->found_count] = search->rom_code;
+    bus->found_count++;
+
+    if(search->is_last_device || (bus->found_count == WIRE_MGR_MAX_DEVICES))
+    {
+        return update_devices();
+    }
+
+    return START_CONVERSION;
+}
+
+/*!
+ * \brief Publishes snapshot of temperatures of all buses
+ *
+ * \details Snapshot is written to buffer not being published, which is
+ * then published with single byte store of sequence counter, whose lowest
+ * bit selects the buffer
+ */
+static void publish_snapshot(void)
+{
+    const uint8_t seq = snapshot_seq;
+    volatile WIRE_MGR_snapshot_t *snap = &snapshots[(seq + 1U) & 1U];
+    uint8_t idx = 0U;
+
+    for(uint8_t i = 0U; i < sizeof(snap->ready_mask); i++)
+    {
+        snap->ready_mask[i] = 0U;
+    }
+
+    for(uint8_t b = 0U; b < buses_count; b++)
+    {
+        for(uint8_t i = 0U; i < buses[b].devices_count; i++)
+        {
+            if(buses[b].devices[i].is_ready)
+            {
+                snap->ready_mask[idx / CHAR_BIT] |= (uint8_t)(1U << (idx % CHAR_BIT));
+            }
+
+            snap->temperature[idx] = buses[b].devices[i].temperature;
+            idx++;
+        }
+    }
+
+    snap->count = idx;
+    snap->tick = SYSTEM_timer_get_tick();
+    snapshot_seq = (uint8_t)(seq + 1U);
+}
+
+/*!
+ * \brief Handles \ref LOG_CONVERSION_RESULT state
+ *
+ * \returns next state
+ */
+static WIRE_state_t handle_log_conversion_results(void)
+{
+    log_result();
+    publish_snapshot();
+
+    switch(bus->old_state)
+    {
+        case WIRE_SENTINEL_STATE:
+        case WIRE_SEARCH_ROM:
+            return WIRE_SEARCH_ROM;
+        case WIRE_READ_ROM:
+        case WIRE_READ_SCRATCHPAD:
+        case WIRE_WRITE_SCRATCHPAD:
+        case WIRE_COPY_SCRATCHPAD:
+            if(bus->result == LOG_FAKE_SENSOR_ERROR)
+            {
+                exclude_device(false);
+                return get_next_identification_state();
+            }
+
+            if(bus->result == LOG_CONFIG_ERROR)
+            {
+                if(bus->write_retries < WRITE_RETRY_LIMIT)
+                {
+                    bus->write_retries++;
+                    return WIRE_WRITE_SCRATCHPAD;
+                }
+
+                /* sensor keeps rejecting configuration e.g. clone with fixed resolution */
+                DEBUG(DL_ERROR, "1WIRE[%d]: configuration rejected\n", bus->current);
+                exclude_device(true);
+                return get_next_identification_state();
+            }
+
+            if(is_warm_boot())
+            {
+                /* stored sensor is missing, table has to be searched again */
+                bus->is_warm_boot = false;
+                return WIRE_SEARCH_ROM;
+            }
+            if(bus->ident_retries < IDENT_RETRY_LIMIT)
+            {
+                /* transient error, scratchpad buffer still holds sensor data */
+                bus->ident_retries++;
+                return bus->old_state;
+            }
+
+            /* failing sensor must not stop the others */
+            DEBUG(DL_ERROR, "1WIRE[%d]: identification failed\n", bus->current);
+            exclude_device(true);
+            return get_next_identification_state();
+        default:
+            return get_next_round_state();
+    }
+}
+
+/*!
+ * \brief Handles \ref WIRE_ERROR_STATE state
+ *
+ * \details There is no valid sensor left, bus is searched again once
+ * \ref EXCLUDE_PERIOD elapsed since the last sensor has been excluded
+ *
+ * \returns next state
+ */
+static WIRE_state_t handle_error_state(void)
+{
+    for(uint8_t i = 0U; i < bus->devices_count; i++)
+    {
+        bus->devices[i].is_ready = false;
+    }
+
+    publish_snapshot();
+
+    if(SYSTEM_timer_tick_difference(bus->exclude_time, SYSTEM_timer_get_tick()) <= EXCLUDE_PERIOD)
+    {
+        return WIRE_ERROR_STATE;
+    }
+
+    return WIRE_SEARCH_ROM;
+}
+
+/*!
+ * \brief Prepares bus transaction of given state
+ *
+ * \param s state to be handled
+ */
+static void prepare_transaction(WIRE_state_t s)
+{
+    begin_transaction();
+
+    switch(s)
+    {
+        case WIRE_READ_ROM:
+            add_select();
+            add_tx_byte(READ_POWER_SUPPLY);
+            set_rx_buffer(&bus->power_supply, sizeof(bus->power_supply));
+            break;
+        case WIRE_READ_SCRATCHPAD:
+            prepare_read_scratchpad(sizeof(bus->scratchpad.raw)/sizeof(bus->scratchpad.raw[0]));
+            break;
+        case WIRE_WRITE_SCRATCHPAD:
+            add_select();
+            add_tx_byte(WRITE_SCRATCHPAD);
+            add_tx_byte((uint8_t)bus->devices[bus->current].th);
+            add_tx_byte((uint8_t)bus->devices[bus->current].tl);
+            if(is_configurable(&bus->devices[bus->current]))
+            {
+                add_tx_byte(get_device_mask(&bus->devices[bus->current]));
+            }
+            break;
+        case WIRE_COPY_SCRATCHPAD:
+            add_select();
+            add_tx_byte(COPY_SCRATCHPAD);
+            bus->transaction.is_pullup = bus->devices[bus->current].is_parasite;
+            break;
+        case START_CONVERSION:
+            if(is_sweep_mode())
+            {
+                /* sweep always starts from first valid sensor */
+                bus->current = (uint8_t)(bus->devices_count - 1U);
+                (void)next_valid_device();
+                add_tx_byte(SKIP_ROM);
+            }
+            else
+            {
+                add_select();
+            }
+            add_tx_byte(CONVERT_T);
+            bus->transaction.is_pullup = bus->is_parasite_bus;
+            break;
+        case READ_CONVERSION_RESULT:
+            prepare_read_scratchpad(is_fast_read() ? SCRATCHPAD_TEMP_SIZE :
+                    sizeof(bus->scratchpad.raw)/sizeof(bus->scratchpad.raw[0]));
+            break;
+        default:
+            ASSERT(false);
+            break;
+    }
+}
+
+/*!
+ * \brief Handles finished transaction of given state
+ *
+ * \param s state to be handled
+ *
+ * \returns next state
+ */
+static WIRE_state_t complete_transaction(WIRE_state_t s)
+{
+    /* engine does not calculate crc, so it is done in separate pass */
+    if(is_async_bus() && is_crc_checked() && bus->transaction.is_presence &&
+            (bus->transaction.rx_len != 0U))
+    {
+        bus->rx_crc = calc_crc_block(0U, bus->transaction.rx, bus->transaction.rx_len);
+    }
+
+    if(bus->transaction.is_presence)
+    {
+        switch(s)
+        {
+            case WIRE_READ_ROM:
+                return handle_read_rom();
+            case WIRE_READ_SCRATCHPAD:
+                return handle_read_scratchpad();
+            case WIRE_WRITE_SCRATCHPAD:
+                return handle_write_scratchpad();
+            case WIRE_COPY_SCRATCHPAD:
+                return handle_copy_scratchpad();
+            case START_CONVERSION:
+                return handle_start_conversion();
+            case READ_CONVERSION_RESULT:
+                return is_sweep_mode() ?
+                    handle_read_sweep_results() : handle_read_conversion_results();
+            default:
+                ASSERT(false);
+                break;
+        }
+
+        return WIRE_SEARCH_ROM;
+    }
+
+    bus->result = LOG_NO_PRESENCE_ERROR;
+    return ((s == READ_CONVERSION_RESULT) && is_read_retry()) ? s : LOG_CONVERSION_RESULT;
+}
+
+/*!
+ * \brief Handles states, which need bus transaction
+ *
+ * \details Transaction is prepared and started on first call. State is
+ * handled once transaction is finished, which in blocking mode without bus
+ * budget happens in the same call. If state needs another transaction e.g.
+ * next sensor of the sweep, it is started straight away.
+ *
+ * \param s state to be handled
+ *
+ * \returns next state
  */
-static void wire_mgr_main(void)
+static WIRE_state_t handle_reset_needed_state(WIRE_state_t s)
+{
+    WIRE_state_t next_state;
+
+    do
+    {
+        if(!bus->is_transaction_pending)
+        {
+            prepare_transaction(s);
+            start_transaction();
+        }
+        else if(!bus->transaction.is_done && !is_async_bus())
+        {
+            /* rest of transaction yielded in previous call */
+            BENCH_START();
+            execute_transaction();
+            BENCH_STOP(BENCH_TRANSACTION_ENTRY());
+        }
+
+        if(!bus->transaction.is_done)
+        {
+            return s;
+        }
+
+        bus->is_transaction_pending = false;
+        next_state = complete_transaction(s);
+    }
+    while(next_state == s);
+
+    return next_state;
+}
+
+/*!
+ * \brief Handles current state of 1Wire manager
+ */
+static void handle_state(void)
 {
-    DEBUG(DL_DEBUG, "State new %d old %d\n", state, old_state);
+    DEBUG(DL_DEBUG, "State new %d old %d\n", bus->state, bus->old_state);
 
+#if WIRE_MGR_STATS_ENABLED
+    const uint32_t start_time = SYSTEM_timer_get_tick();
+    WIRE_device_t *dev = &bus->devices[bus->current];
+#endif
     WIRE_state_t new_state = WIRE_SENTINEL_STATE;
+    BENCH_START();
 
-    switch(state)
+    switch(bus->state)
     {
+        case WIRE_SEARCH_ROM:
+            new_state = handle_search_rom();
+            break;
         case WIRE_READ_ROM:
         case WIRE_READ_SCRATCHPAD:
         case WIRE_WRITE_SCRATCHPAD:
-        case START_CONVERSION:
+        case WIRE_COPY_SCRATCHPAD:
         case READ_CONVERSION_RESULT:
-            new_state = handle_reset_needed_state(state);
+            new_state = handle_reset_needed_state(bus->state);
+            break;
+        case START_CONVERSION:
+            /* sampling round waits for its interval */
+            new_state = (bus->is_transaction_pending || (get_sample_delay() == 0U)) ?
+                handle_reset_needed_state(bus->state) : START_CONVERSION;
+            break;
+        case WAIT_FOR_COPY:
+            new_state = handle_wait_for_copy();
             break;
         case WAIT_FOR_CONVERTION:
             new_state = handle_wait_for_conversion();
             break;
+        case WIRE_ALARM_SEARCH:
+            new_state = handle_alarm_search();
+            break;
+        case WIRE_DISCOVERY:
+            new_state = handle_discovery();
+            break;
         case LOG_CONVERSION_RESULT:
             new_state = handle_log_conversion_results();
             break;
@@ -659,26 +3301,504 @@ static void wire_mgr_main(void)
             break;
     }
 
-    old_state = state;
-    state = new_state;
+#if WIRE_MGR_STATS_ENABLED
+    /* time is accounted to the sensor handled on entry */
+    dev->bus_time += (uint16_t)SYSTEM_timer_tick_difference(start_time,
+            SYSTEM_timer_get_tick());
+#endif
+    BENCH_STOP(bus->state);
+
+    bus->old_state = bus->state;
+    bus->state = new_state;
 }
 
-bool WIRE_MGR_get_temperature(int16_t *out)
+/*!
+ * \brief Gets time the current state has to wait before being handled
+ *
+ * \returns delay in ticks, 0 if state can be handled straight away
+ */
+static uint16_t get_state_delay(void)
+{
+    switch(bus->state)
+    {
+        case WAIT_FOR_CONVERTION:
+        {
+            const uint8_t poll_interval = get_poll_interval();
+            const uint32_t elapsed =
+                SYSTEM_timer_tick_difference(bus->start_conv_time, SYSTEM_timer_get_tick());
+            uint16_t delay;
+
+            if(elapsed > bus->conversion_time)
+            {
+                return 0U;
+            }
+
+            delay = (uint16_t)(bus->conversion_time - elapsed + 1U);
+
+            if((poll_interval != 0U) && (poll_interval < delay))
+            {
+                delay = poll_interval;
+            }
+
+            return delay;
+        }
+        case WAIT_FOR_COPY:
+        {
+            const uint32_t elapsed =
+                SYSTEM_timer_tick_difference(bus->start_copy_time, SYSTEM_timer_get_tick());
+
+            return (elapsed > COPY_SCRATCHPAD_TIME) ?
+                0U : (uint16_t)(COPY_SCRATCHPAD_TIME - elapsed + 1U);
+        }
+        case WIRE_ERROR_STATE:
+            return TASK_PERIOD;
+        case START_CONVERSION:
+            if(!bus->is_transaction_pending && (get_sample_delay() != 0U))
+            {
+                return get_sample_delay();
+            }
+            /* fall through */
+        default:
+            if(bus->is_transaction_pending || bus->is_search_pending)
+            {
+                /* check again on next task call */
+                return 1U;
+            }
+
+            if((bus->old_state == LOG_CONVERSION_RESULT) && (bus->result != LOG_SUCCESS))
+            {
+                /* missing presence or failed search is failure of whole bus,
+                 * it is backed off not to hammer broken bus */
+                if((bus->result == LOG_NO_PRESENCE_ERROR) || (bus->state == WIRE_SEARCH_ROM))
+                {
+                    return TASK_PERIOD;
+                }
+
+                /* error of single sensor is retried on next tick */
+                return 1U;
+            }
+            return 0U;
+    }
+}
+
+/*!
+ * \brief Handles state machine of handled bus
+ */
+static void handle_bus(void)
+{
+    const bool is_fast = config.is_fast_scheduling;
+
+    if(!is_fast)
+    {
+        handle_state();
+        return;
+    }
+
+    if(SYSTEM_timer_tick_difference(bus->wakeup_time, SYSTEM_timer_get_tick()) < bus->wakeup_delay)
+    {
+        return;
+    }
+
+    for(uint8_t i = 0U; i < RUN_THROUGH_LIMIT; i++)
+    {
+        handle_state();
+        bus->wakeup_delay = get_state_delay();
+
+        if(bus->wakeup_delay != 0U)
+        {
+            break;
+        }
+    }
+
+    bus->wakeup_time = SYSTEM_timer_get_tick();
+}
+
+/*!
+ * \brief 1Wire manager task function
+ *
+ * \details Buses are handled one after another, so while one bus waits for
+ * conversion the others are read out
+ */
+static void wire_mgr_main(void)
+{
+#if WIRE_MGR_BENCH_ENABLED
+    const uint16_t start = TCNT1;
+    uint32_t cycles;
+#endif
+
+    bus_budget = config.bus_budget;
+
+    for(uint8_t i = 0U; i < buses_count; i++)
+    {
+        bus = &buses[i];
+        handle_bus();
+    }
+
+#if WIRE_MGR_BENCH_ENABLED
+    cycles = (uint32_t)(uint16_t)(TCNT1 - start) * WIRE_MGR_BENCH_PRESCALER;
+    bench_record(BENCH_MAIN, cycles);
+    bench_sample_sum += cycles;
+
+    if(!bench_is_sampled)
+    {
+        return;
+    }
+
+    /* calls from previous logged sample up to this one */
+    bench_record(BENCH_SAMPLE, bench_sample_sum);
+    bench_sample_sum = 0U;
+    bench_is_sampled = false;
+    bench_samples++;
+
+    if(bench_samples == WIRE_MGR_BENCH_REPORT_SAMPLES)
+    {
+        bench_samples = 0U;
+        bench_report();
+    }
+#endif
+}
+
+/*!
+ * \brief Initializes state of bus
+ *
+ * \param b bus to be initialized
+ * \param port bus primitives
+ */
+static void init_bus(WIRE_bus_t *b, const WIRE_MGR_port_t *port)
+{
+    memset(b, 0, sizeof(*b));
+    b->port = port;
+    b->state = WIRE_SEARCH_ROM;
+    b->old_state = WIRE_SENTINEL_STATE;
+    b->conversion_time = RESOLUTION_CONV_TIME;
+
+#if WIRE_MGR_ROM_CACHE_ENABLED
+    bus = b;
+
+    if(load_rom_table())
+    {
+        /* stored sensors are verified by identification */
+        b->is_warm_boot = true;
+        b->state = WIRE_READ_ROM;
+    }
+#endif
+}
+
+/*!
+ * \brief Finds sensor of given index of public API
+ *
+ * \details Sensors are indexed across buses, in order of bus registration
+ *
+ * \param idx index of sensor
+ *
+ * \returns sensor, NULL if index is out of range
+ */
+static WIRE_device_t *get_device(uint8_t idx)
+{
+    uint8_t i = idx;
+
+    for(uint8_t b = 0U; b < buses_count; b++)
+    {
+        if(i < buses[b].devices_count)
+        {
+            return &buses[b].devices[i];
+        }
+
+        i -= buses[b].devices_count;
+    }
+
+    return NULL;
+}
+
+bool WIRE_MGR_get_temperature_n(uint8_t idx, int16_t *out)
+{
+    const WIRE_device_t *dev = get_device(idx);
+
+    ASSERT(out != NULL);
+
+    if((dev != NULL) && dev->is_ready)
+    {
+        *out = dev->temperature;
+        return true;
+    }
+
+    return false;
+}
+
+bool WIRE_MGR_get_filtered_temperature(uint8_t idx, int16_t *out)
 {
+    const WIRE_device_t *dev = get_device(idx);
+
     ASSERT(out != NULL);
 
-    if(is_sensor_ready)
+    if((dev != NULL) && dev->is_filtered)
     {
-        *out = temperature;
+        *out = get_filtered_value(dev);
         return true;
     }
 
     return false;
 }
 
+bool WIRE_MGR_get_temperature(int16_t *out)
+{
+    return WIRE_MGR_get_temperature_n(0U, out);
+}
+
+uint8_t WIRE_MGR_get_devices_count(void)
+{
+    uint8_t ret = 0U;
+
+    for(uint8_t i = 0U; i < buses_count; i++)
+    {
+        ret += buses[i].devices_count;
+    }
+
+    return ret;
+}
+
+uint8_t WIRE_MGR_get_bus_devices_count(uint8_t bus_idx)
+{
+    if(bus_idx >= buses_count)
+    {
+        return 0U;
+    }
+
+    return buses[bus_idx].devices_count;
+}
+
+uint8_t WIRE_MGR_read_samples(uint16_t *seq, WIRE_MGR_sample_t *out, uint8_t size)
+{
+    uint16_t available;
+    uint8_t copied = 0U;
+
+    ASSERT(seq != NULL);
+    ASSERT(out != NULL);
+
+    available = (uint16_t)(samples_seq - *seq);
+
+    if(available > WIRE_MGR_SAMPLES_SIZE)
+    {
+        *seq = (uint16_t)(samples_seq - WIRE_MGR_SAMPLES_SIZE);
+        available = WIRE_MGR_SAMPLES_SIZE;
+    }
+
+    while((copied < size) && (copied < available))
+    {
+        out[copied] = samples[*seq % WIRE_MGR_SAMPLES_SIZE];
+        (*seq)++;
+        copied++;
+    }
+
+    return copied;
+}
+
+bool WIRE_MGR_read_snapshot(WIRE_MGR_snapshot_t *out)
+{
+    const uint8_t seq = snapshot_seq;
+
+    ASSERT(out != NULL);
+
+    *out = snapshots[seq & 1U];
+
+    /* next publishing writes the copied buffer before the counter moves */
+    return (snapshot_seq == seq);
+}
+
+bool WIRE_MGR_get_stats(uint8_t idx, WIRE_MGR_stats_t *out)
+{
+#if WIRE_MGR_STATS_ENABLED
+    const WIRE_device_t *dev = get_device(idx);
+    const WIRE_stats_t *stats;
+    uint32_t total = 0U;
+
+    ASSERT(out != NULL);
+
+    if(dev == NULL)
+    {
+        return false;
+    }
+
+    stats = &dev->stats;
+
+    for(uint8_t i = 0U; i < LOG_SENTINEL; i++)
+    {
+        total += stats->count[i];
+    }
+
+    out->success = stats->count[LOG_SUCCESS];
+    out->crc_errors = stats->count[LOG_CRC_ERROR];
+    out->no_presence_errors = stats->count[LOG_NO_PRESENCE_ERROR];
+    out->fake_errors = stats->count[LOG_FAKE_SENSOR_ERROR];
+    out->config_errors = stats->count[LOG_CONFIG_ERROR];
+    out->retries = stats->retries;
+    out->bus_time_min = stats->bus_time_min;
+    out->bus_time_avg = (total != 0U) ? (uint16_t)(stats->bus_time_sum / total) : 0U;
+    out->bus_time_max = stats->bus_time_max;
+    out->latency_min = stats->latency_min;
+    out->latency_avg = (out->success != 0U) ?
+        (uint16_t)(stats->latency_sum / out->success) : 0U;
+    out->latency_max = stats->latency_max;
+    return true;
+#else
+    (void)idx;
+    ASSERT(out != NULL);
+    return false;
+#endif
+}
+
+bool WIRE_MGR_set_alarm(uint8_t idx, int8_t th, int8_t tl)
+{
+    WIRE_device_t *dev = get_device(idx);
+
+    if((dev == NULL) || (th < tl))
+    {
+        return false;
+    }
+
+    dev->th = th;
+    dev->tl = tl;
+    dev->is_alarm_set = true;
+    /* thresholds are written with the next configuration of the sensor */
+    dev->is_configured = false;
+    return true;
+}
+
+void WIRE_MGR_register_sample_callback(WIRE_MGR_sample_cb_t cb)
+{
+    sample_cb = cb;
+}
+
+bool WIRE_MGR_set_config(const WIRE_MGR_config_t *cfg)
+{
+    ASSERT(cfg != NULL);
+
+    if(!is_config_valid(cfg))
+    {
+        return false;
+    }
+
+#if WIRE_MGR_STATIC_CONFIG
+    if((cfg->is_crc != CONFIG_IS_CRC) || (cfg->is_fake_allowed != CONFIG_IS_FAKE_ALLOWED) ||
+            (cfg->resolution != CONFIG_RESOLUTION))
+    {
+        /* compile time constants can't be changed */
+        return false;
+    }
+#endif
+
+    if(cfg->is_fast_scheduling != config.is_fast_scheduling)
+    {
+        /* task period has been registered with the initial mode */
+        return false;
+    }
+
+    if(cfg->resolution != config.resolution)
+    {
+        /* sensors are reconfigured by the manager task */
+        for(uint8_t b = 0U; b < buses_count; b++)
+        {
+            for(uint8_t i = 0U; i < buses[b].devices_count; i++)
+            {
+                if(is_configurable(&buses[b].devices[i]))
+                {
+                    buses[b].devices[i].resolution = cfg->resolution;
+                    buses[b].devices[i].is_configured = false;
+                }
+            }
+        }
+    }
+
+    if(cfg->filter != config.filter)
+    {
+        /* state of previous filter is meaningless for the new one */
+        for(uint8_t b = 0U; b < buses_count; b++)
+        {
+            for(uint8_t i = 0U; i < buses[b].devices_count; i++)
+            {
+                buses[b].devices[i].is_filtered = false;
+                buses[b].devices[i].window_count = 0U;
+                buses[b].devices[i].window_pos = 0U;
+            }
+        }
+    }
+
+    config = *cfg;
+    apply_config();
+    return true;
+}
+
+void WIRE_MGR_get_config(WIRE_MGR_config_t *out)
+{
+    ASSERT(out != NULL);
+
+    *out = config;
+}
+
+bool WIRE_MGR_is_idle(uint16_t *wakeup_in)
+{
+    const uint32_t now = SYSTEM_timer_get_tick();
+    uint16_t ret = UINT16_MAX;
+
+    ASSERT(wakeup_in != NULL);
+
+    if(!config.is_fast_scheduling)
+    {
+        return false;
+    }
+
+    for(uint8_t i = 0U; i < buses_count; i++)
+    {
+        const uint32_t elapsed = SYSTEM_timer_tick_difference(buses[i].wakeup_time, now);
+
+        if(elapsed >= buses[i].wakeup_delay)
+        {
+            return false;
+        }
+
+        if((buses[i].wakeup_delay - elapsed) < ret)
+        {
+            ret = (uint16_t)(buses[i].wakeup_delay - elapsed);
+        }
+    }
+
+    *wakeup_in = ret;
+    return true;
+}
+
+bool WIRE_MGR_register_bus(const WIRE_MGR_port_t *port)
+{
+    ASSERT(port != NULL);
+
+    if(buses_count >= WIRE_MGR_MAX_BUSES)
+    {
+        return false;
+    }
+
+    init_bus(&buses[buses_count], port);
+    buses_count++;
+    return true;
+}
+
 void WIRE_MGR_initialize(void)
 {
-    const uint8_t resolution = pgm_read_byte(&wire_mgr_config.resolution);
-    conversion_time = get_resolution_conv_time(resolution);
-    SYSTEM_register_task(wire_mgr_main, TASK_PERIOD);
+    memcpy_P(&config, &wire_mgr_config, sizeof(config));
+    ASSERT(is_config_valid(&config));
+    apply_config();
+
+    init_bus(&buses[0], &default_port);
+    buses_count = 1U;
+#if WIRE_MGR_BENCH_ENABLED
+    /* Timer1 free running for the benchmark */
+    TCCR1A = 0U;
+    TCCR1B = BENCH_CLOCK_SELECT;
+
+    for(uint8_t i = 0U; i < BENCH_CRC_RUNS; i++)
+    {
+        BENCH_START();
+        (void)calc_crc_block(0U, buses[0].scratchpad.raw, sizeof(buses[0].scratchpad.raw));
+        BENCH_STOP(BENCH_CRC_BLOCK);
+    }
+#endif
+    SYSTEM_register_task(wire_mgr_main, config.is_fast_scheduling ? TASK_FAST_PERIOD : TASK_PERIOD);
 }
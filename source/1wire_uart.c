@@ -0,0 +1,323 @@
+/*!
+ * \file
+ * \brief 1 wire UART backend implementation file
+ * \author Dawid Babula
+ * \email dbabula@adventurous.pl
+ *
+ * \par Copyright (C) Dawid Babula, 2020
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "1wire_uart.h"
+#include "1wire_async.h"
+#include "1wire.h"
+#include <stddef.h>
+#include <limits.h>
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include "hardware.h"
+
+#ifndef WIRE_UART_RX_vect
+/*!
+ * \brief USART receive complete interrupt vector
+ */
+#define WIRE_UART_RX_vect           USART_RX_vect
+#endif
+
+/*!
+ * \brief Baud rate of reset/presence frame
+ */
+#define RESET_BAUD                  (9600UL)
+
+/*!
+ * \brief Baud rate of read/write slot frames
+ */
+#define DATA_BAUD                   (115200UL)
+
+/*!
+ * \brief UBRR value for given baud rate in double speed mode
+ */
+#define UBRR_VALUE(baud)            ((uint16_t)(((F_CPU) + 4UL * (baud)) / (8UL * (baud)) - 1UL))
+
+/*!
+ * \brief Frame generating reset pulse
+ */
+#define RESET_FRAME                 (0xF0U)
+
+/*!
+ * \brief Frame generating write 1 or read slot
+ */
+#define ONE_FRAME                   (0xFFU)
+
+/*!
+ * \brief Frame generating write 0 slot
+ */
+#define ZERO_FRAME                  (0x00U)
+
+/*!
+ * \brief Phases of asynchronous transaction
+ */
+typedef enum
+{
+    PHASE_RESET, /*!< reset and presence pulse */
+    PHASE_TX, /*!< sending bytes */
+    PHASE_RX, /*!< reading bytes */
+    PHASE_ABORT, /*!< reset aborting transfer */
+} WIRE_UART_phase_t;
+
+static WIRE_transaction_t *volatile active;
+static WIRE_UART_phase_t phase;
+static uint8_t byte_idx;
+static uint8_t bit_idx;
+static uint8_t shift;
+
+/*!
+ * \brief Sets USART baud rate
+ *
+ * \param ubrr value of baud rate register
+ */
+static inline void set_baud(uint16_t ubrr)
+{
+    UBRR0H = (uint8_t)(ubrr >> CHAR_BIT);
+    UBRR0L = (uint8_t)ubrr;
+}
+
+/*!
+ * \brief Drops stale frames from receive buffer
+ */
+static inline void flush_rx(void)
+{
+    while(UCSR0A & (1U << RXC0))
+    {
+        (void)UDR0;
+    }
+}
+
+/*!
+ * \brief Sends frame and waits for its echo
+ *
+ * \param frame frame to be sent
+ *
+ * \returns echo of the frame, state of the bus
+ */
+static uint8_t transfer(uint8_t frame)
+{
+    flush_rx();
+
+    while(!(UCSR0A & (1U << UDRE0)))
+    {
+    }
+
+    UDR0 = frame;
+
+    while(!(UCSR0A & (1U << RXC0)))
+    {
+    }
+
+    return UDR0;
+}
+
+/*!
+ * \brief Checks echo of reset frame
+ *
+ * \param echo echo of reset frame
+ *
+ * \retval true presence pulse detected
+ * \retval false no presence pulse or bus shorted
+ */
+static inline bool is_presence(uint8_t echo)
+{
+    return (echo != RESET_FRAME) && (echo != ZERO_FRAME);
+}
+
+bool WIRE_reset(void)
+{
+    uint8_t echo;
+
+    set_baud(UBRR_VALUE(RESET_BAUD));
+    echo = transfer(RESET_FRAME);
+    set_baud(UBRR_VALUE(DATA_BAUD));
+
+    return is_presence(echo);
+}
+
+void WIRE_send_bit(bool bit)
+{
+    (void)transfer(bit ? ONE_FRAME : ZERO_FRAME);
+}
+
+bool WIRE_read_bit(void)
+{
+    return (transfer(ONE_FRAME) == ONE_FRAME);
+}
+
+void WIRE_send_byte(uint8_t byte)
+{
+    for(uint8_t i = 0U; i < CHAR_BIT; i++)
+    {
+        WIRE_send_bit((byte & (1U << i)) != 0U);
+    }
+}
+
+uint8_t WIRE_read_byte(void)
+{
+    uint8_t ret = 0U;
+
+    for(uint8_t i = 0U; i < CHAR_BIT; i++)
+    {
+        if(WIRE_read_bit())
+        {
+            ret |= (uint8_t)(1U << i);
+        }
+    }
+
+    return ret;
+}
+
+void WIRE_set_strong_pullup(bool is_enabled)
+{
+#ifdef WIRE_UART_PULLUP_PIN
+    if(is_enabled)
+    {
+        WIRE_UART_PULLUP_PORT |= (1U << WIRE_UART_PULLUP_PIN);
+    }
+    else
+    {
+        WIRE_UART_PULLUP_PORT &= (uint8_t)~(1U << WIRE_UART_PULLUP_PIN);
+    }
+#else
+    (void)is_enabled;
+#endif
+}
+
+/*!
+ * \brief Finishes active asynchronous transaction
+ */
+static void finish_transaction(void)
+{
+    UCSR0B &= (uint8_t)~(1U << RXCIE0);
+    active->is_done = true;
+    active = NULL;
+}
+
+ISR(WIRE_UART_RX_vect)
+{
+    const uint8_t echo = UDR0;
+    WIRE_transaction_t *t = active;
+
+    switch(phase)
+    {
+        case PHASE_RESET:
+            set_baud(UBRR_VALUE(DATA_BAUD));
+            t->is_presence = is_presence(echo);
+
+            if(!t->is_presence)
+            {
+                finish_transaction();
+                return;
+            }
+
+            phase = PHASE_TX;
+            break;
+        case PHASE_TX:
+            bit_idx++;
+            break;
+        case PHASE_RX:
+            shift >>= 1U;
+
+            if(echo == ONE_FRAME)
+            {
+                shift |= (uint8_t)(1U << (CHAR_BIT - 1U));
+            }
+
+            bit_idx++;
+
+            if(bit_idx == CHAR_BIT)
+            {
+                t->rx[byte_idx] = shift;
+            }
+            break;
+        case PHASE_ABORT:
+        default:
+            set_baud(UBRR_VALUE(DATA_BAUD));
+            finish_transaction();
+            return;
+    }
+
+    if(bit_idx == CHAR_BIT)
+    {
+        bit_idx = 0U;
+        byte_idx++;
+    }
+
+    if(phase == PHASE_TX)
+    {
+        if(byte_idx < t->tx_len)
+        {
+            UDR0 = (t->tx[byte_idx] & (1U << bit_idx)) ? ONE_FRAME : ZERO_FRAME;
+            return;
+        }
+
+        if(t->is_pullup)
+        {
+            WIRE_set_strong_pullup(true);
+        }
+
+        phase = PHASE_RX;
+        byte_idx = 0U;
+    }
+
+    if(byte_idx < t->rx_len)
+    {
+        UDR0 = ONE_FRAME;
+        return;
+    }
+
+    if(t->is_abort)
+    {
+        phase = PHASE_ABORT;
+        set_baud(UBRR_VALUE(RESET_BAUD));
+        UDR0 = RESET_FRAME;
+        return;
+    }
+
+    finish_transaction();
+}
+
+void WIRE_async_start(WIRE_transaction_t *transaction)
+{
+    active = transaction;
+    phase = PHASE_RESET;
+    byte_idx = 0U;
+    bit_idx = 0U;
+    shift = 0U;
+
+    flush_rx();
+    set_baud(UBRR_VALUE(RESET_BAUD));
+    UCSR0B |= (1U << RXCIE0);
+    UDR0 = RESET_FRAME;
+}
+
+void WIRE_UART_initialize(void)
+{
+#ifdef WIRE_UART_PULLUP_PIN
+    WIRE_UART_PULLUP_DDR |= (1U << WIRE_UART_PULLUP_PIN);
+#endif
+    UCSR0A = (1U << U2X0);
+    UCSR0C = (1U << UCSZ01) | (1U << UCSZ00);
+    UCSR0B = (1U << RXEN0) | (1U << TXEN0);
+    set_baud(UBRR_VALUE(DATA_BAUD));
+}
@@ -0,0 +1,37 @@
+/*!
+ * \file
+ * \brief Host stub of 1Wire driver, primitives are served by simulated bus
+ * \author Dawid Babula
+ * \email dbabula@adventurous.pl
+ *
+ * \par Copyright (C) Dawid Babula, 2020
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef IWIRE_H
+#define IWIRE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+bool WIRE_reset(void);
+void WIRE_send_byte(uint8_t byte);
+uint8_t WIRE_read_byte(void);
+void WIRE_send_bit(bool bit);
+bool WIRE_read_bit(void);
+void WIRE_set_strong_pullup(bool is_enabled);
+
+#endif
@@ -0,0 +1,42 @@
+/*!
+ * \file
+ * \brief Host stub of AVR EEPROM access, EEPROM variables live in RAM
+ * \author Dawid Babula
+ * \email dbabula@adventurous.pl
+ *
+ * \par Copyright (C) Dawid Babula, 2020
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef EEPROM_H
+#define EEPROM_H
+
+#include <stddef.h>
+#include <string.h>
+
+#define EEMEM
+
+static inline void eeprom_read_block(void *dst, const void *src, size_t size)
+{
+    memcpy(dst, src, size);
+}
+
+static inline void eeprom_update_block(const void *src, void *dst, size_t size)
+{
+    memcpy(dst, src, size);
+}
+
+#endif
@@ -0,0 +1,57 @@
+/*!
+ * \file
+ * \brief Host stub of debug module, messages go to stderr
+ * \author Dawid Babula
+ * \email dbabula@adventurous.pl
+ *
+ * \par Copyright (C) Dawid Babula, 2020
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef DEBUG_H
+#define DEBUG_H
+
+#include <assert.h>
+#include <stdio.h>
+
+enum
+{
+    DL_VERBOSE,
+    DL_DEBUG,
+    DL_INFO,
+    DL_WARNING,
+    DL_ERROR,
+};
+
+/*!
+ * \brief Lowest level of printed messages, set from command line
+ */
+extern int sim_debug_level;
+
+#define DEBUG(level, fmt, ...) \
+    do \
+    { \
+        if((int)(level) >= sim_debug_level) \
+        { \
+            fprintf(stderr, fmt, __VA_ARGS__); \
+        } \
+    } while(0)
+
+#define DEBUG_DUMP_HEX(level, buffer, size) do { (void)(buffer); (void)(size); } while(0)
+
+#define ASSERT(x) assert(x)
+
+#endif
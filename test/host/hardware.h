@@ -0,0 +1,34 @@
+/*!
+ * \file
+ * \brief Host stub of hardware configuration
+ * \author Dawid Babula
+ * \email dbabula@adventurous.pl
+ *
+ * \par Copyright (C) Dawid Babula, 2020
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef HARDWARE_H
+#define HARDWARE_H
+
+#include "1wire_mgr.h"
+
+/*!
+ * \brief Configuration of manager, not const so it is set from command line
+ */
+extern WIRE_MGR_config_t wire_mgr_config;
+
+#endif
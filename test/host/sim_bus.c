@@ -0,0 +1,811 @@
+/*!
+ * \file
+ * \brief Simulated 1Wire bus of DS18B20 sensors implementation file
+ * \author Dawid Babula
+ * \email dbabula@adventurous.pl
+ *
+ * \par Copyright (C) Dawid Babula, 2020
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "sim_bus.h"
+#include "1wire.h"
+#include <limits.h>
+#include <string.h>
+
+/*!
+ * \brief Duration of reset pulse and presence detection
+ */
+#define RESET_TIME                  (960u)
+
+/*!
+ * \brief Duration of single read or write time slot
+ */
+#define SLOT_TIME                   (65u)
+
+/*!
+ * \brief Conversion time of DS18B20 in 9 bits resolution
+ */
+#define CONVERSION_TIME_9BIT        (93750u)
+
+/*!
+ * \brief Conversion time of DS18S20
+ */
+#define CONVERSION_TIME_DS18S20     (750000u)
+
+#define FAMILY_DS18B20              (0x28u)
+#define FAMILY_DS18S20              (0x10u)
+
+#define SEARCH_ROM                  (0xF0u)
+#define READ_ROM                    (0x33u)
+#define MATCH_ROM                   (0x55u)
+#define SKIP_ROM                    (0xCCu)
+#define ALARM_SEARCH                (0xECu)
+
+#define CONVERT_T                   (0x44u)
+#define WRITE_SCRATCHPAD            (0x4Eu)
+#define READ_SCRATCHPAD             (0xBEu)
+#define COPY_SCRATCHPAD             (0x48u)
+#define RECALL_EEPROM               (0xB8u)
+#define READ_POWER_SUPPLY           (0xB4u)
+
+#define ROM_SIZE                    (8u)
+#define SCRATCHPAD_SIZE             (9u)
+
+/*!
+ * \brief Phases of bus communication after reset
+ */
+typedef enum
+{
+    PHASE_IGNORE, /*!< no device listens, e.g. after missing presence */
+    PHASE_ROM_CMD, /*!< ROM command expected */
+    PHASE_MATCH, /*!< rom space of MATCH_ROM being received */
+    PHASE_SEARCH, /*!< SEARCH_ROM or ALARM_SEARCH bit triplets */
+    PHASE_FUNC_CMD, /*!< function command expected */
+    PHASE_READ, /*!< response being read */
+    PHASE_WRITE, /*!< WRITE_SCRATCHPAD bytes being received */
+    PHASE_CONVERT, /*!< conversion started, read slots tell completion */
+    PHASE_POWER, /*!< READ_POWER_SUPPLY answered with read slots */
+} SIM_phase_t;
+
+/*!
+ * \brief Structure represents simulated sensor
+ */
+typedef struct
+{
+    uint8_t rom[ROM_SIZE]; /*!< rom space */
+    uint8_t scratchpad[SCRATCHPAD_SIZE]; /*!< scratchpad space */
+    uint8_t eeprom[3]; /*!< TH, TL and configuration register in EEPROM */
+    int16_t temperature; /*!< true temperature in 1/16 of degree */
+    bool is_parasite; /*!< sensor is parasite powered */
+    bool is_selected; /*!< sensor is addressed by ROM command */
+    bool is_converting; /*!< conversion is in progress */
+    bool is_alarming; /*!< last conversion is out of TH/TL bounds */
+    uint64_t conversion_end; /*!< time of end of conversion */
+} SIM_device_t;
+
+/*!
+ * \brief Structure represents simulated bus
+ */
+typedef struct
+{
+    SIM_device_t devices[SIM_BUS_MAX_DEVICES]; /*!< connected devices */
+    uint8_t devices_count; /*!< number of connected devices */
+    SIM_device_t unplugged[SIM_BUS_MAX_DEVICES]; /*!< disconnected sensors */
+    uint8_t unplugged_count; /*!< number of disconnected sensors */
+    SIM_phase_t phase; /*!< phase of communication */
+    uint8_t response[SCRATCHPAD_SIZE]; /*!< response being read */
+    uint8_t response_size; /*!< size of response */
+    uint8_t pos; /*!< position in response or received bytes */
+    uint8_t match[ROM_SIZE]; /*!< rom space of MATCH_ROM */
+    uint8_t search_bit; /*!< bit of rom space being searched */
+    uint8_t search_step; /*!< step of search triplet */
+    uint8_t corrupt_pos; /*!< position of corrupted byte of response */
+    uint8_t corrupt_mask; /*!< flipped bits of corrupted byte, 0 if none */
+} SIM_bus_t;
+
+static SIM_bus_config_t config;
+static SIM_fault_cb_t fault_cb;
+static SIM_bus_t buses[SIM_BUS_MAX_BUSES];
+static SIM_bus_t *sim = &buses[0];
+static uint64_t now;
+static uint64_t busy_time;
+static uint32_t faults[SIM_FAULT_SENTINEL];
+static uint32_t random_state;
+
+/*!
+ * \brief Generates pseudo random number
+ *
+ * \returns random number
+ */
+static uint32_t get_random(void)
+{
+    /* xorshift32 */
+    random_state ^= random_state << 13U;
+    random_state ^= random_state >> 17U;
+    random_state ^= random_state << 5U;
+    return random_state;
+}
+
+/*!
+ * \brief Draws event of given probability
+ *
+ * \param per_mille probability of event in per mille
+ *
+ * \retval true event happens
+ * \retval false event doesn't happen
+ */
+static bool is_drawn(uint16_t per_mille)
+{
+    return (per_mille != 0U) && ((get_random() % 1000U) < per_mille);
+}
+
+/*!
+ * \brief Calculates Dallas/Maxim crc8
+ *
+ * \param buffer data
+ * \param size size of data
+ *
+ * \returns crc of data
+ */
+static uint8_t calc_crc(const uint8_t *buffer, uint8_t size)
+{
+    uint8_t crc = 0U;
+
+    for(uint8_t i = 0U; i < size; i++)
+    {
+        crc ^= buffer[i];
+
+        for(uint8_t j = 0U; j < CHAR_BIT; j++)
+        {
+            crc = (crc & 0x01U) ? (uint8_t)((crc >> 1U) ^ 0x8CU) : (uint8_t)(crc >> 1U);
+        }
+    }
+
+    return crc;
+}
+
+/*!
+ * \brief Injects fault
+ *
+ * \param fault injected fault
+ */
+static void inject(SIM_fault_t fault)
+{
+    faults[fault]++;
+
+    if(fault_cb != NULL)
+    {
+        fault_cb(fault);
+    }
+}
+
+/*!
+ * \brief Advances time by bus activity
+ *
+ * \param time duration of activity in microseconds
+ */
+static void spend(uint32_t time)
+{
+    now += time;
+    busy_time += time;
+}
+
+/*!
+ * \brief Checks whatever device is DS18B20
+ *
+ * \param dev device
+ *
+ * \retval true device is DS18B20
+ * \retval false device is DS18S20
+ */
+static bool is_ds18b20(const SIM_device_t *dev)
+{
+    return (dev->rom[0] == FAMILY_DS18B20);
+}
+
+/*!
+ * \brief Finishes conversions, which time has passed
+ */
+static void update_conversions(void)
+{
+    for(uint8_t i = 0U; i < sim->devices_count; i++)
+    {
+        SIM_device_t *dev = &sim->devices[i];
+        int16_t raw;
+
+        if(!dev->is_converting || (now < dev->conversion_end))
+        {
+            continue;
+        }
+
+        dev->is_converting = false;
+        /* slow drift of +-1/16 degree per conversion */
+        dev->temperature = (int16_t)(dev->temperature + (int16_t)(get_random() % 3U) - 1);
+
+        if(is_ds18b20(dev))
+        {
+            const uint8_t resolution = (dev->scratchpad[4] >> 5U) & 0x03U;
+
+            /* undefined low bits of lower resolutions read as zero */
+            raw = (int16_t)(dev->temperature & (int16_t)~((1U << (3U - resolution)) - 1U));
+        }
+        else
+        {
+            raw = (int16_t)(dev->temperature >> 3U);
+        }
+
+        dev->scratchpad[0] = (uint8_t)raw;
+        dev->scratchpad[1] = (uint8_t)((uint16_t)raw >> CHAR_BIT);
+        dev->scratchpad[SCRATCHPAD_SIZE - 1U] = calc_crc(dev->scratchpad, SCRATCHPAD_SIZE - 1U);
+        dev->is_alarming = ((dev->temperature >> 4) >= (int8_t)dev->scratchpad[2]) ||
+            ((dev->temperature >> 4) <= (int8_t)dev->scratchpad[3]);
+    }
+}
+
+/*!
+ * \brief Starts response read by master, bytes of all selected devices are
+ * wired AND-ed
+ *
+ * \param is_rom response is rom space, scratchpad space otherwise
+ */
+static void start_response(bool is_rom)
+{
+    sim->response_size = is_rom ? ROM_SIZE : SCRATCHPAD_SIZE;
+    memset(sim->response, 0xFF, sizeof(sim->response));
+
+    for(uint8_t i = 0U; i < sim->devices_count; i++)
+    {
+        if(sim->devices[i].is_selected)
+        {
+            for(uint8_t j = 0U; j < sim->response_size; j++)
+            {
+                sim->response[j] &= is_rom ? sim->devices[i].rom[j] : sim->devices[i].scratchpad[j];
+            }
+        }
+    }
+
+    sim->corrupt_mask = 0U;
+
+    if(!is_rom && is_drawn(config.crc_error))
+    {
+        sim->corrupt_pos = (uint8_t)(get_random() % SCRATCHPAD_SIZE);
+        sim->corrupt_mask = (uint8_t)(1U << (get_random() % CHAR_BIT));
+    }
+
+    sim->pos = 0U;
+    sim->phase = PHASE_READ;
+}
+
+/*!
+ * \brief Selects devices for ROM command
+ *
+ * \param is_alarm only alarming devices are selected
+ */
+static void select_all(bool is_alarm)
+{
+    for(uint8_t i = 0U; i < sim->devices_count; i++)
+    {
+        sim->devices[i].is_selected = !is_alarm || sim->devices[i].is_alarming;
+    }
+}
+
+/*!
+ * \brief Handles ROM command
+ *
+ * \param cmd ROM command
+ */
+static void handle_rom_command(uint8_t cmd)
+{
+    switch(cmd)
+    {
+        case SKIP_ROM:
+            select_all(false);
+            sim->phase = PHASE_FUNC_CMD;
+            break;
+        case MATCH_ROM:
+            sim->pos = 0U;
+            sim->phase = PHASE_MATCH;
+            break;
+        case READ_ROM:
+            select_all(false);
+            start_response(true);
+            break;
+        case SEARCH_ROM:
+        case ALARM_SEARCH:
+            select_all(cmd == ALARM_SEARCH);
+            sim->search_bit = 0U;
+            sim->search_step = 0U;
+            sim->phase = PHASE_SEARCH;
+            break;
+        default:
+            sim->phase = PHASE_IGNORE;
+            break;
+    }
+}
+
+/*!
+ * \brief Handles function command
+ *
+ * \param cmd function command
+ */
+static void handle_function_command(uint8_t cmd)
+{
+    switch(cmd)
+    {
+        case CONVERT_T:
+            for(uint8_t i = 0U; i < sim->devices_count; i++)
+            {
+                SIM_device_t *dev = &sim->devices[i];
+                uint32_t time = CONVERSION_TIME_DS18S20;
+
+                if(!dev->is_selected)
+                {
+                    continue;
+                }
+
+                if(is_ds18b20(dev))
+                {
+                    time = CONVERSION_TIME_9BIT << ((dev->scratchpad[4] >> 5U) & 0x03U);
+                }
+
+                dev->is_converting = true;
+                dev->conversion_end = now + (uint64_t)time * config.conversion / 100U;
+            }
+            sim->phase = PHASE_CONVERT;
+            break;
+        case READ_SCRATCHPAD:
+            start_response(false);
+            break;
+        case WRITE_SCRATCHPAD:
+            sim->pos = 0U;
+            sim->phase = PHASE_WRITE;
+            break;
+        case COPY_SCRATCHPAD:
+            for(uint8_t i = 0U; i < sim->devices_count; i++)
+            {
+                if(sim->devices[i].is_selected)
+                {
+                    memcpy(sim->devices[i].eeprom, &sim->devices[i].scratchpad[2], sizeof(sim->devices[i].eeprom));
+                }
+            }
+            sim->phase = PHASE_IGNORE;
+            break;
+        case READ_POWER_SUPPLY:
+            sim->phase = PHASE_POWER;
+            break;
+        default:
+            sim->phase = PHASE_IGNORE;
+            break;
+    }
+}
+
+/*!
+ * \brief Handles byte of WRITE_SCRATCHPAD
+ *
+ * \param byte received byte
+ */
+static void handle_write(uint8_t byte)
+{
+    for(uint8_t i = 0U; i < sim->devices_count; i++)
+    {
+        SIM_device_t *dev = &sim->devices[i];
+
+        if(!dev->is_selected || (!is_ds18b20(dev) && (sim->pos == 2U)))
+        {
+            continue;
+        }
+
+        /* only resolution bits of configuration register are writable */
+        dev->scratchpad[2U + sim->pos] = (sim->pos == 2U) ? (uint8_t)((byte & 0x60U) | 0x1FU) : byte;
+        dev->scratchpad[SCRATCHPAD_SIZE - 1U] = calc_crc(dev->scratchpad, SCRATCHPAD_SIZE - 1U);
+    }
+
+    sim->pos++;
+
+    if(sim->pos == 3U)
+    {
+        sim->phase = PHASE_IGNORE;
+    }
+}
+
+/*!
+ * \brief Checks whatever any selected device is parasite powered
+ *
+ * \retval true parasite powered device selected
+ * \retval false all selected devices are externally powered
+ */
+static bool is_parasite_selected(void)
+{
+    for(uint8_t i = 0U; i < sim->devices_count; i++)
+    {
+        if(sim->devices[i].is_selected && sim->devices[i].is_parasite)
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/*!
+ * \brief Checks whatever conversions of selected devices are finished
+ *
+ * \retval true conversions finished
+ * \retval false any selected device is still converting
+ */
+static bool is_conversion_done(void)
+{
+    for(uint8_t i = 0U; i < sim->devices_count; i++)
+    {
+        if(sim->devices[i].is_selected && sim->devices[i].is_converting)
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/*!
+ * \brief Handles read time slot
+ *
+ * \returns state of the bus in the slot
+ */
+static bool read_slot(void)
+{
+    bool bit = true;
+
+    update_conversions();
+
+    switch(sim->phase)
+    {
+        case PHASE_SEARCH:
+            if(sim->search_step < 2U)
+            {
+                const uint8_t byte = sim->search_bit / CHAR_BIT;
+                const uint8_t mask = (uint8_t)(1U << (sim->search_bit % CHAR_BIT));
+
+                /* selected devices drive true bit, then its complement */
+                for(uint8_t i = 0U; i < sim->devices_count; i++)
+                {
+                    if(sim->devices[i].is_selected)
+                    {
+                        const bool id_bit = ((sim->devices[i].rom[byte] & mask) != 0U);
+
+                        bit = bit && ((sim->search_step == 0U) ? id_bit : !id_bit);
+                    }
+                }
+
+                sim->search_step++;
+            }
+            break;
+        case PHASE_CONVERT:
+            bit = is_conversion_done();
+            break;
+        case PHASE_POWER:
+            bit = !is_parasite_selected();
+            break;
+        default:
+            break;
+    }
+
+    spend(SLOT_TIME);
+    return bit;
+}
+
+bool WIRE_reset(void)
+{
+    update_conversions();
+    spend(RESET_TIME);
+
+    if((sim->devices_count == 0U) || is_drawn(config.no_presence))
+    {
+        if(sim->devices_count != 0U)
+        {
+            inject(SIM_FAULT_NO_PRESENCE);
+        }
+
+        sim->phase = PHASE_IGNORE;
+        return false;
+    }
+
+    sim->phase = PHASE_ROM_CMD;
+    return true;
+}
+
+void WIRE_send_byte(uint8_t byte)
+{
+    update_conversions();
+    spend(CHAR_BIT * SLOT_TIME);
+
+    switch(sim->phase)
+    {
+        case PHASE_ROM_CMD:
+            handle_rom_command(byte);
+            break;
+        case PHASE_MATCH:
+            sim->match[sim->pos] = byte;
+            sim->pos++;
+
+            if(sim->pos == ROM_SIZE)
+            {
+                for(uint8_t i = 0U; i < sim->devices_count; i++)
+                {
+                    sim->devices[i].is_selected = (memcmp(sim->devices[i].rom, sim->match, ROM_SIZE) == 0);
+                }
+
+                sim->phase = PHASE_FUNC_CMD;
+            }
+            break;
+        case PHASE_FUNC_CMD:
+            handle_function_command(byte);
+            break;
+        case PHASE_WRITE:
+            handle_write(byte);
+            break;
+        default:
+            break;
+    }
+}
+
+uint8_t WIRE_read_byte(void)
+{
+    uint8_t byte = 0U;
+
+    if(sim->phase != PHASE_READ)
+    {
+        for(uint8_t i = 0U; i < CHAR_BIT; i++)
+        {
+            if(read_slot())
+            {
+                byte |= (uint8_t)(1U << i);
+            }
+        }
+
+        return byte;
+    }
+
+    update_conversions();
+    spend(CHAR_BIT * SLOT_TIME);
+
+    if(sim->pos >= sim->response_size)
+    {
+        return 0xFFU;
+    }
+
+    byte = sim->response[sim->pos];
+
+    if((sim->corrupt_mask != 0U) && (sim->pos == sim->corrupt_pos))
+    {
+        byte ^= sim->corrupt_mask;
+        inject(SIM_FAULT_CRC);
+    }
+
+    sim->pos++;
+    return byte;
+}
+
+void WIRE_send_bit(bool bit)
+{
+    update_conversions();
+    spend(SLOT_TIME);
+
+    if((sim->phase != PHASE_SEARCH) || (sim->search_step != 2U))
+    {
+        return;
+    }
+
+    /* devices not matching chosen direction stop searching */
+    for(uint8_t i = 0U; i < sim->devices_count; i++)
+    {
+        const uint8_t byte = sim->search_bit / CHAR_BIT;
+        const uint8_t mask = (uint8_t)(1U << (sim->search_bit % CHAR_BIT));
+
+        if(((sim->devices[i].rom[byte] & mask) != 0U) != bit)
+        {
+            sim->devices[i].is_selected = false;
+        }
+    }
+
+    sim->search_step = 0U;
+    sim->search_bit++;
+
+    if(sim->search_bit == ROM_SIZE * CHAR_BIT)
+    {
+        sim->phase = PHASE_FUNC_CMD;
+    }
+}
+
+bool WIRE_read_bit(void)
+{
+    return read_slot();
+}
+
+void WIRE_set_strong_pullup(bool is_enabled)
+{
+    (void)is_enabled;
+}
+
+/*!
+ * \brief Initializes simulated device
+ *
+ * \param dev device
+ * \param family family code
+ * \param idx index of device, sets its temperature
+ */
+static void init_device(SIM_device_t *dev, uint8_t family, uint8_t idx)
+{
+    static const uint8_t ds18b20_scratchpad[SCRATCHPAD_SIZE] = {
+        0x50, 0x05, 0x4B, 0x46, 0x7F, 0xFF, 0x0C, 0x10, 0x00
+    };
+    static const uint8_t ds18s20_scratchpad[SCRATCHPAD_SIZE] = {
+        0xAA, 0x00, 0x4B, 0x46, 0xFF, 0xFF, 0x0C, 0x10, 0x00
+    };
+
+    memset(dev, 0, sizeof(*dev));
+    dev->rom[0] = family;
+
+    /* serial_no[4] and serial_no[5] are zero on genuine sensors */
+    for(uint8_t i = 1U; i < 5U; i++)
+    {
+        dev->rom[i] = (uint8_t)get_random();
+    }
+
+    dev->rom[7] = calc_crc(dev->rom, ROM_SIZE - 1U);
+    memcpy(dev->scratchpad, (family == FAMILY_DS18B20) ? ds18b20_scratchpad : ds18s20_scratchpad,
+            SCRATCHPAD_SIZE);
+    dev->scratchpad[SCRATCHPAD_SIZE - 1U] = calc_crc(dev->scratchpad, SCRATCHPAD_SIZE - 1U);
+    memcpy(dev->eeprom, &dev->scratchpad[2], sizeof(dev->eeprom));
+    /* 20 degrees and 0.5 degree more on each next device */
+    dev->temperature = (int16_t)((20 << 4) + (idx << 3));
+}
+
+void SIM_bus_initialize(const SIM_bus_config_t *cfg, SIM_fault_cb_t cb)
+{
+    config = *cfg;
+    fault_cb = cb;
+    random_state = (cfg->seed != 0U) ? cfg->seed : 1U;
+    memset(buses, 0, sizeof(buses));
+
+    /* buses are populated alike, one at least */
+    for(uint8_t b = 0U; (b == 0U) || ((b < cfg->buses) && (b < SIM_BUS_MAX_BUSES)); b++)
+    {
+        sim = &buses[b];
+
+        for(uint8_t i = 0U; (i < cfg->devices) && (sim->devices_count < SIM_BUS_MAX_DEVICES); i++)
+        {
+            init_device(&sim->devices[sim->devices_count], FAMILY_DS18B20, sim->devices_count);
+            sim->devices[sim->devices_count].is_parasite = (i < cfg->parasite);
+            sim->devices_count++;
+        }
+
+        for(uint8_t i = 0U; (i < cfg->foreign) && (sim->devices_count < SIM_BUS_MAX_DEVICES); i++)
+        {
+            init_device(&sim->devices[sim->devices_count], FAMILY_DS18S20, sim->devices_count);
+            sim->devices_count++;
+        }
+
+        sim->phase = PHASE_IGNORE;
+    }
+
+    sim = &buses[0];
+    now = 0U;
+    busy_time = 0U;
+    memset(faults, 0, sizeof(faults));
+}
+
+void SIM_bus_select(uint8_t idx)
+{
+    if(idx < SIM_BUS_MAX_BUSES)
+    {
+        sim = &buses[idx];
+    }
+}
+
+/*!
+ * \brief Disconnects DS18B20 sensors of bus, devices of other family stay
+ *
+ * \param b simulated bus
+ */
+static void unplug_sensors(SIM_bus_t *b)
+{
+    uint8_t count = 0U;
+
+    for(uint8_t i = 0U; i < b->devices_count; i++)
+    {
+        if(is_ds18b20(&b->devices[i]))
+        {
+            b->unplugged[b->unplugged_count] = b->devices[i];
+            b->unplugged_count++;
+        }
+        else
+        {
+            b->devices[count] = b->devices[i];
+            count++;
+        }
+    }
+
+    b->devices_count = count;
+    b->phase = PHASE_IGNORE;
+}
+
+/*!
+ * \brief Connects disconnected sensors of bus back
+ *
+ * \details Sensors come back like after power up, scratchpad holds
+ * configuration recalled from EEPROM and power on temperature of 85 degrees
+ *
+ * \param b simulated bus
+ */
+static void plug_sensors(SIM_bus_t *b)
+{
+    for(uint8_t i = 0U; (i < b->unplugged_count) && (b->devices_count < SIM_BUS_MAX_DEVICES); i++)
+    {
+        SIM_device_t *dev = &b->devices[b->devices_count];
+
+        *dev = b->unplugged[i];
+        dev->is_selected = false;
+        dev->is_converting = false;
+        dev->is_alarming = false;
+        dev->scratchpad[0] = 0x50U;
+        dev->scratchpad[1] = 0x05U;
+        memcpy(&dev->scratchpad[2], dev->eeprom, sizeof(dev->eeprom));
+        dev->scratchpad[SCRATCHPAD_SIZE - 1U] = calc_crc(dev->scratchpad, SCRATCHPAD_SIZE - 1U);
+        b->devices_count++;
+    }
+
+    b->unplugged_count = 0U;
+    b->phase = PHASE_IGNORE;
+}
+
+void SIM_bus_set_plugged(bool is_plugged)
+{
+    for(uint8_t b = 0U; b < SIM_BUS_MAX_BUSES; b++)
+    {
+        if(is_plugged)
+        {
+            plug_sensors(&buses[b]);
+        }
+        else
+        {
+            unplug_sensors(&buses[b]);
+        }
+    }
+}
+
+uint64_t SIM_bus_get_time(void)
+{
+    return now;
+}
+
+void SIM_bus_wait_until(uint64_t time)
+{
+    if(time > now)
+    {
+        now = time;
+    }
+}
+
+uint64_t SIM_bus_get_busy_time(void)
+{
+    return busy_time;
+}
+
+uint32_t SIM_bus_get_faults(SIM_fault_t fault)
+{
+    return faults[fault];
+}
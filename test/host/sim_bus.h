@@ -0,0 +1,142 @@
+/*!
+ * \file
+ * \brief Simulated 1Wire bus of DS18B20 sensors header file
+ * \author Dawid Babula
+ * \email dbabula@adventurous.pl
+ *
+ * \par Copyright (C) Dawid Babula, 2020
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef SIM_BUS_H
+#define SIM_BUS_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/*!
+ *
+ * \addtogroup sim_bus
+ * \ingroup 1wire_mgr
+ * \brief Byte and bit level model of DS18B20 sensors on 1Wire buses
+ *
+ * \details Model serves WIRE_* primitives of 1wire.h on selected bus and
+ * keeps simulated time in microseconds, advanced by reset pulses and time
+ * slots of all buses. Faults are injected with given probability, reported
+ * through fault callback.
+ */
+
+/*@{*/
+
+/*!
+ * \brief Maximal number of simulated sensors
+ */
+#define SIM_BUS_MAX_DEVICES         (32u)
+
+/*!
+ * \brief Maximal number of simulated buses
+ */
+#define SIM_BUS_MAX_BUSES           (4u)
+
+/*!
+ * \brief Faults injected by the model
+ */
+typedef enum
+{
+    SIM_FAULT_CRC, /*!< bit of scratchpad space flipped on read */
+    SIM_FAULT_NO_PRESENCE, /*!< reset without presence pulse */
+    SIM_FAULT_SENTINEL,
+} SIM_fault_t;
+
+/*!
+ * \brief Configuration of simulated bus
+ */
+typedef struct
+{
+    uint8_t devices; /*!< number of DS18B20 sensors */
+    uint8_t parasite; /*!< number of them, which are parasite powered */
+    uint8_t foreign; /*!< number of devices of other family on the bus */
+    uint16_t crc_error; /*!< per mille of corrupted scratchpad reads */
+    uint16_t no_presence; /*!< per mille of resets without presence */
+    uint16_t conversion; /*!< conversion time in percent of datasheet maximum */
+    uint32_t seed; /*!< seed of fault injection and temperatures */
+    uint8_t buses; /*!< number of buses, each with the devices above */
+} SIM_bus_config_t;
+
+/*!
+ * \brief Callback called when fault is injected
+ *
+ * \param fault injected fault
+ */
+typedef void (*SIM_fault_cb_t)(SIM_fault_t fault);
+
+/*!
+ * \brief Initializes simulated bus
+ *
+ * \param cfg configuration of the bus
+ * \param cb callback of injected faults, can be NULL
+ */
+void SIM_bus_initialize(const SIM_bus_config_t *cfg, SIM_fault_cb_t cb);
+
+/*!
+ * \brief Selects bus served by WIRE_* primitives
+ *
+ * \param idx index of the bus, bus 0 is selected after initialization
+ */
+void SIM_bus_select(uint8_t idx);
+
+/*!
+ * \brief Disconnects or connects back DS18B20 sensors of all buses
+ *
+ * \details Devices of other family stay on the buses, connected sensors
+ * come back like after power up
+ *
+ * \param is_plugged true connects sensors, false disconnects them
+ */
+void SIM_bus_set_plugged(bool is_plugged);
+
+/*!
+ * \brief Gets simulated time
+ *
+ * \returns time in microseconds
+ */
+uint64_t SIM_bus_get_time(void);
+
+/*!
+ * \brief Lets simulated time pass without bus activity
+ *
+ * \param time time in microseconds to wait for
+ */
+void SIM_bus_wait_until(uint64_t time);
+
+/*!
+ * \brief Gets time of bus activity
+ *
+ * \returns time of reset pulses and time slots in microseconds
+ */
+uint64_t SIM_bus_get_busy_time(void);
+
+/*!
+ * \brief Gets number of injected faults
+ *
+ * \param fault kind of fault
+ *
+ * \returns number of faults of the kind
+ */
+uint32_t SIM_bus_get_faults(SIM_fault_t fault);
+
+/*@}*/
+#endif
@@ -0,0 +1,502 @@
+/*!
+ * \file
+ * \brief Host simulation of 1Wire manager on simulated bus of DS18B20 sensors
+ * \author Dawid Babula
+ * \email dbabula@adventurous.pl
+ *
+ * \par Copyright (C) Dawid Babula, 2020
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/*
+ * Manager is built into the simulation, so state of its buses can be
+ * sampled when faults are injected
+ */
+#include "../../source/1wire_mgr.c"
+#include "sim_bus.h"
+#include <inttypes.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+/*!
+ * \brief Structure represents statistics of measured value
+ */
+typedef struct
+{
+    uint32_t count; /*!< number of measurements */
+    uint64_t sum; /*!< sum of measured values */
+    uint64_t max; /*!< maximal measured value */
+} SIM_stat_t;
+
+/*!
+ * \brief Names of states, keys of recovery latency
+ */
+static const char *const state_names[WIRE_SENTINEL_STATE + 1U] = {
+    [WIRE_SEARCH_ROM] = "WIRE_SEARCH_ROM",
+    [WIRE_READ_ROM] = "WIRE_READ_ROM",
+    [WIRE_READ_SCRATCHPAD] = "WIRE_READ_SCRATCHPAD",
+    [WIRE_WRITE_SCRATCHPAD] = "WIRE_WRITE_SCRATCHPAD",
+    [WIRE_COPY_SCRATCHPAD] = "WIRE_COPY_SCRATCHPAD",
+    [WAIT_FOR_COPY] = "WAIT_FOR_COPY",
+    [START_CONVERSION] = "START_CONVERSION",
+    [WAIT_FOR_CONVERTION] = "WAIT_FOR_CONVERTION",
+    [WIRE_ALARM_SEARCH] = "WIRE_ALARM_SEARCH",
+    [WIRE_DISCOVERY] = "WIRE_DISCOVERY",
+    [READ_CONVERSION_RESULT] = "READ_CONVERSION_RESULT",
+    [LOG_CONVERSION_RESULT] = "LOG_CONVERSION_RESULT",
+    [WIRE_ERROR_STATE] = "WIRE_ERROR_STATE",
+    [WIRE_SENTINEL_STATE] = "WIRE_SENTINEL_STATE",
+};
+
+int sim_debug_level = DL_ERROR + 1;
+
+WIRE_MGR_config_t wire_mgr_config = {
+    .is_crc = true,
+    .resolution = WIRE_12BIT_RESOLUTION,
+    .is_fast_scheduling = true,
+    .read_retries = 1U,
+};
+
+static SYSTEM_task_t task;
+static uint16_t task_period;
+static SIM_stat_t ticks_per_sample[WIRE_MGR_SNAPSHOT_SIZE];
+static SIM_stat_t ticks_all;
+static SIM_stat_t bus_time_per_sample;
+static SIM_stat_t recovery[WIRE_SENTINEL_STATE + 1U];
+static uint32_t last_sample_tick[WIRE_MGR_SNAPSHOT_SIZE];
+static bool is_sampled[WIRE_MGR_SNAPSHOT_SIZE];
+static uint64_t last_busy_time;
+static uint32_t sim_samples;
+static bool is_recovering;
+static WIRE_state_t fault_state;
+static uint32_t fault_tick;
+static uint8_t sim_buses = 1U;
+static uint64_t next_call;
+
+void SYSTEM_register_task(SYSTEM_task_t t, uint16_t period)
+{
+    task = t;
+    task_period = period;
+}
+
+uint32_t SYSTEM_timer_get_tick(void)
+{
+    return (uint32_t)(SIM_bus_get_time() / 1000U);
+}
+
+uint32_t SYSTEM_timer_tick_difference(uint32_t prev, uint32_t next)
+{
+    return next - prev;
+}
+
+/*!
+ * \brief Issues reset on simulated bus of handled additional bus
+ *
+ * \details Primitives of additional buses serve the bus handled by the
+ * manager and select bus 0 back for the default port
+ *
+ * \retval true presence pulse
+ * \retval false no presence pulse
+ */
+static bool sim_reset(void)
+{
+    SIM_bus_select((uint8_t)(bus - buses));
+    const bool ret = WIRE_reset();
+    SIM_bus_select(0U);
+    return ret;
+}
+
+/*!
+ * \brief Sends byte on simulated bus of handled additional bus
+ *
+ * \param byte byte to send
+ */
+static void sim_send_byte(uint8_t byte)
+{
+    SIM_bus_select((uint8_t)(bus - buses));
+    WIRE_send_byte(byte);
+    SIM_bus_select(0U);
+}
+
+/*!
+ * \brief Reads byte from simulated bus of handled additional bus
+ *
+ * \returns read byte
+ */
+static uint8_t sim_read_byte(void)
+{
+    SIM_bus_select((uint8_t)(bus - buses));
+    const uint8_t ret = WIRE_read_byte();
+    SIM_bus_select(0U);
+    return ret;
+}
+
+/*!
+ * \brief Sends bit on simulated bus of handled additional bus
+ *
+ * \param bit bit to send
+ */
+static void sim_send_bit(bool bit)
+{
+    SIM_bus_select((uint8_t)(bus - buses));
+    WIRE_send_bit(bit);
+    SIM_bus_select(0U);
+}
+
+/*!
+ * \brief Reads bit from simulated bus of handled additional bus
+ *
+ * \returns read bit
+ */
+static bool sim_read_bit(void)
+{
+    SIM_bus_select((uint8_t)(bus - buses));
+    const bool ret = WIRE_read_bit();
+    SIM_bus_select(0U);
+    return ret;
+}
+
+/*!
+ * \brief Port of additional buses
+ */
+static const WIRE_MGR_port_t sim_port = {
+    .reset = sim_reset,
+    .send_byte = sim_send_byte,
+    .read_byte = sim_read_byte,
+    .send_bit = sim_send_bit,
+    .read_bit = sim_read_bit,
+    .set_strong_pullup = WIRE_set_strong_pullup,
+};
+
+/*!
+ * \brief Adds measurement to statistics
+ *
+ * \param st statistics
+ * \param value measured value
+ */
+static void add_stat(SIM_stat_t *st, uint64_t value)
+{
+    st->count++;
+    st->sum += value;
+
+    if(value > st->max)
+    {
+        st->max = value;
+    }
+}
+
+/*!
+ * \brief Prints statistics as SIM,name,key,count,avg,max line
+ *
+ * \param name name of measured value
+ * \param key key of measurement
+ * \param st statistics
+ */
+static void print_stat(const char *name, const char *key, const SIM_stat_t *st)
+{
+    const uint64_t avg = (st->count != 0U) ? (st->sum / st->count) : 0U;
+
+    printf("SIM,%s,%s,%" PRIu32 ",%" PRIu64 ",%" PRIu64 "\n", name, key, st->count, avg, st->max);
+}
+
+/*!
+ * \brief Collects measurements of new sample
+ *
+ * \param idx index of sensor
+ * \param raw raw temperature
+ */
+static void on_sample(uint8_t idx, int16_t raw)
+{
+    const uint32_t tick = SYSTEM_timer_get_tick();
+    const uint64_t busy_time = SIM_bus_get_busy_time();
+
+    (void)raw;
+    ASSERT(idx < WIRE_MGR_SNAPSHOT_SIZE);
+
+    if(is_sampled[idx])
+    {
+        add_stat(&ticks_per_sample[idx], tick - last_sample_tick[idx]);
+        add_stat(&ticks_all, tick - last_sample_tick[idx]);
+    }
+
+    is_sampled[idx] = true;
+    last_sample_tick[idx] = tick;
+    add_stat(&bus_time_per_sample, busy_time - last_busy_time);
+    last_busy_time = busy_time;
+    sim_samples++;
+
+    if(is_recovering)
+    {
+        add_stat(&recovery[fault_state], tick - fault_tick);
+        is_recovering = false;
+    }
+}
+
+/*!
+ * \brief Notes state, in which first fault since last sample is injected
+ *
+ * \param fault injected fault
+ */
+static void on_fault(SIM_fault_t fault)
+{
+    (void)fault;
+
+    if(is_recovering)
+    {
+        return;
+    }
+
+    is_recovering = true;
+    fault_state = (bus != NULL) ? bus->state : WIRE_SENTINEL_STATE;
+    fault_tick = SYSTEM_timer_get_tick();
+}
+
+/*!
+ * \brief Initializes manager and registers additional buses
+ */
+static void start_manager(void)
+{
+    WIRE_MGR_initialize();
+
+    for(uint8_t i = 1U; i < sim_buses; i++)
+    {
+        if(!WIRE_MGR_register_bus(&sim_port))
+        {
+            fprintf(stderr, "WIRE_MGR_MAX_BUSES is %u\n", WIRE_MGR_MAX_BUSES);
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    ASSERT(task != NULL);
+}
+
+/*!
+ * \brief Calls task of the manager with its period
+ */
+static void run_task(void)
+{
+    SIM_bus_wait_until(next_call);
+    next_call = SIM_bus_get_time() + (uint64_t)task_period * 1000U;
+    task();
+}
+
+/*!
+ * \brief Prints usage of the simulation
+ *
+ * \param name name of executable
+ */
+static void usage(const char *name)
+{
+    fprintf(stderr,
+            "usage: %s [options]\n"
+            " -n N   DS18B20 sensors on each bus (1)\n"
+            " -x N   parasite powered ones of them (0)\n"
+            " -o N   devices of other family on the bus (0)\n"
+            " -c N   per mille of corrupted scratchpad reads (0)\n"
+            " -p N   per mille of resets without presence (0)\n"
+            " -k N   conversion time in percent of datasheet maximum (100)\n"
+            " -R N   resolution 0..3 (3)\n"
+            " -t N   read retries (1)\n"
+            " -b N   bus budget per task call, 0 is unlimited (0)\n"
+            " -S     sweep mode\n"
+            " -A     alarm sweep mode\n"
+            " -C     classic scheduling with fixed task period\n"
+            " -P N   poll interval of conversion completion, 0 disables (0)\n"
+            " -F N   filter 0..2 (0)\n"
+            " -H     hot plug\n"
+            " -u N   second, in which sensors are unplugged\n"
+            " -U N   second, in which sensors are plugged back\n"
+            " -B N   buses, each with the devices above (1)\n"
+            " -W     warm boot from table stored by preceding cold boot\n"
+            " -s N   samples per sensor to simulate (100)\n"
+            " -l N   limit of simulated time in seconds (3600)\n"
+            " -r N   seed (1)\n"
+            " -v N   print manager messages from debug level N\n"
+            " -h     this help\n",
+            name);
+}
+
+int main(int argc, char *argv[])
+{
+    SIM_bus_config_t bus_cfg = { .devices = 1U, .conversion = 100U, .seed = 1U, .buses = 1U };
+    uint32_t samples_per_sensor = 100U;
+    uint64_t limit = 3600U;
+    uint64_t unplug_time = 0U;
+    uint64_t plug_time = 0U;
+    bool is_warm_boot = false;
+    bool is_plugged = true;
+    bool is_emptied = false;
+    bool is_passed;
+    uint32_t target;
+    uint8_t expected;
+    uint8_t count;
+    int opt;
+
+    while((opt = getopt(argc, argv, "n:x:o:c:p:k:R:t:b:SACP:F:Hu:U:B:Ws:l:r:v:h")) != -1)
+    {
+        switch(opt)
+        {
+            case 'n': bus_cfg.devices = (uint8_t)atoi(optarg); break;
+            case 'x': bus_cfg.parasite = (uint8_t)atoi(optarg); break;
+            case 'o': bus_cfg.foreign = (uint8_t)atoi(optarg); break;
+            case 'c': bus_cfg.crc_error = (uint16_t)atoi(optarg); break;
+            case 'p': bus_cfg.no_presence = (uint16_t)atoi(optarg); break;
+            case 'k': bus_cfg.conversion = (uint16_t)atoi(optarg); break;
+            case 'R': wire_mgr_config.resolution = (uint8_t)atoi(optarg); break;
+            case 't': wire_mgr_config.read_retries = (uint8_t)atoi(optarg); break;
+            case 'b': wire_mgr_config.bus_budget = (uint8_t)atoi(optarg); break;
+            case 'S': wire_mgr_config.is_sweep = true; break;
+            case 'A': wire_mgr_config.is_alarm_sweep = true; break;
+            case 'C': wire_mgr_config.is_fast_scheduling = false; break;
+            case 'P': wire_mgr_config.poll_interval = (uint8_t)atoi(optarg); break;
+            case 'F': wire_mgr_config.filter = (uint8_t)atoi(optarg); break;
+            case 'H': wire_mgr_config.is_hot_plug = true; break;
+            case 'u': unplug_time = (uint64_t)atoll(optarg) * 1000000U; break;
+            case 'U': plug_time = (uint64_t)atoll(optarg) * 1000000U; break;
+            case 'B': bus_cfg.buses = (uint8_t)atoi(optarg); break;
+            case 'W': is_warm_boot = true; break;
+            case 's': samples_per_sensor = (uint32_t)atoi(optarg); break;
+            case 'l': limit = (uint64_t)atoll(optarg); break;
+            case 'r': bus_cfg.seed = (uint32_t)atoi(optarg); break;
+            case 'v': sim_debug_level = atoi(optarg); break;
+            case 'h':
+                usage(argv[0]);
+                return EXIT_SUCCESS;
+            default:
+                usage(argv[0]);
+                return EXIT_FAILURE;
+        }
+    }
+
+    if((bus_cfg.buses == 0U) || (bus_cfg.buses > SIM_BUS_MAX_BUSES))
+    {
+        usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    sim_buses = bus_cfg.buses;
+    expected = (uint8_t)(bus_cfg.devices * sim_buses);
+    target = samples_per_sensor * expected;
+    limit *= 1000000U;
+    SIM_bus_initialize(&bus_cfg, on_fault);
+
+    if(is_warm_boot)
+    {
+#if WIRE_MGR_ROM_CACHE_ENABLED
+        /* cold boot stores table of found sensors in EEPROM */
+        start_manager();
+
+        while((WIRE_MGR_get_devices_count() != expected) && (SIM_bus_get_time() < limit))
+        {
+            run_task();
+        }
+#else
+        fprintf(stderr, "-W needs WIRE_MGR_ROM_CACHE_ENABLED\n");
+        return EXIT_FAILURE;
+#endif
+    }
+
+    start_manager();
+    WIRE_MGR_register_sample_callback(on_sample);
+
+#if WIRE_MGR_ROM_CACHE_ENABLED
+    if(is_warm_boot && !buses[0].is_warm_boot)
+    {
+        fprintf(stderr, "table of sensors not loaded from EEPROM\n");
+        return EXIT_FAILURE;
+    }
+#endif
+
+    /* runs until enough samples are logged after all scheduled plugging */
+    while(SIM_bus_get_time() < limit)
+    {
+        const uint64_t time = SIM_bus_get_time();
+
+        if(is_plugged && (unplug_time != 0U) && (time >= unplug_time) &&
+                ((plug_time <= unplug_time) || (time < plug_time)))
+        {
+            SIM_bus_set_plugged(false);
+            is_plugged = false;
+        }
+        else if(!is_plugged && (plug_time > unplug_time) && (time >= plug_time))
+        {
+            SIM_bus_set_plugged(true);
+            is_plugged = true;
+        }
+
+        if((time >= plug_time) && (time >= unplug_time) && is_plugged && (sim_samples >= target))
+        {
+            break;
+        }
+
+        run_task();
+
+        if(!is_plugged && (WIRE_MGR_get_devices_count() == 0U))
+        {
+            is_emptied = true;
+        }
+    }
+
+    count = WIRE_MGR_get_devices_count();
+    printf("SIM,name,key,count,avg,max\n");
+
+    for(uint8_t i = 0U; i < count; i++)
+    {
+        char key[4];
+
+        snprintf(key, sizeof(key), "%u", i);
+        print_stat("ticks_per_sample", key, &ticks_per_sample[i]);
+    }
+
+    print_stat("ticks_per_sample", "all", &ticks_all);
+    print_stat("bus_us_per_sample", "all", &bus_time_per_sample);
+
+    for(uint8_t i = 0U; i <= WIRE_SENTINEL_STATE; i++)
+    {
+        if(recovery[i].count != 0U)
+        {
+            print_stat("recovery_ticks", state_names[i], &recovery[i]);
+        }
+    }
+
+    printf("SIM,faults,crc,%" PRIu32 ",,\n", SIM_bus_get_faults(SIM_FAULT_CRC));
+    printf("SIM,faults,no_presence,%" PRIu32 ",,\n", SIM_bus_get_faults(SIM_FAULT_NO_PRESENCE));
+    printf("SIM,devices,found,%u,,\n", count);
+    printf("SIM,devices,emptied,%u,,\n", is_emptied);
+    printf("SIM,samples,all,%" PRIu32 ",,\n", sim_samples);
+    printf("SIM,time,ticks,%" PRIu32 ",,\n", SYSTEM_timer_get_tick());
+
+    /*
+     * Unplugged sensors have to leave the table, plugged ones be sampled.
+     * Bus without presence pulse can't be told from bus fault, so table
+     * is kept unless devices of other family are left on the bus.
+     */
+    if(is_plugged)
+    {
+        is_passed = (count == expected) && (sim_samples >= target);
+    }
+    else
+    {
+        is_passed = (count == 0U) || (bus_cfg.foreign == 0U);
+    }
+
+    if((unplug_time != 0U) && (bus_cfg.foreign != 0U))
+    {
+        is_passed = is_passed && is_emptied;
+    }
+
+    return is_passed ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,32 @@
+/*!
+ * \file
+ * \brief Host stub of system timer, ticks are milliseconds of simulated time
+ * \author Dawid Babula
+ * \email dbabula@adventurous.pl
+ *
+ * \par Copyright (C) Dawid Babula, 2020
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef SYSTEM_TIMER_H
+#define SYSTEM_TIMER_H
+
+#include <stdint.h>
+
+uint32_t SYSTEM_timer_get_tick(void);
+uint32_t SYSTEM_timer_tick_difference(uint32_t prev, uint32_t next);
+
+#endif